@@ -101,6 +101,7 @@ int main() {
     #define A(x) x          //函數巨集
     #define MIN(A，B)  ( (A)  <= (B) ? (A) : (B))
     #define SUM(a,b) (a+b)  //要括號，不然SUM(2,3)*10會先成3再加2
+    對整個 vector 做運算不要用巨集，可用 expression template 融合成一個迴圈 (見 topic/expression template.cpp)
     
     <Headfile內部>
     #ifndef MYHEADER  //避免重複引入
@@ -130,6 +131,7 @@ int main() {
     union data s;
     s.b='A';      //u.b='A'; u.a[1]=0; u.a[0]=65; (ASCII表示A), sizeof(s)=8;
                   //union讓a[2],b共用了記憶體空間，為節省記憶體的做法
+                  //union不記錄目前存的是哪個成員，需要安全的 8 bytes 混合型態可用 NaN boxing (見 topic/nan boxing.cpp)
                   
     ##########################
     ###### Stack & Queue #####
@@ -1,16 +1,20 @@
 #include <iostream>
+#include "topic/trace.h"   //編譯時加 -DTRACE 可記錄各段花費的時間 (見 topic/trace.h)
 using namespace std;
 
 int main() {
     //資料型態 (1byte=8bits)
-    cout << sizeof(bool) << endl;   //1 byte bool
-    cout << sizeof(char) << endl;   //1 byte char
-    cout << sizeof(short) << endl;  //2 byte short
-    cout << sizeof(long) << endl;   //8 byte long
-    cout << sizeof(float) << endl;  //4 bytes float
-    cout << sizeof(double) << endl; //8 bytes double (有小數點預設用double存)
-    cout << sizeof(int) << endl;    //4 bytes int (可表正負2^31以內的數，超過會overflow
-    // 可用unsigned int存到2^32的數但只有正號)
+    {
+        TRACE_SCOPE("資料型態 輸出");
+        cout << sizeof(bool) << endl;   //1 byte bool
+        cout << sizeof(char) << endl;   //1 byte char
+        cout << sizeof(short) << endl;  //2 byte short
+        cout << sizeof(long) << endl;   //8 byte long
+        cout << sizeof(float) << endl;  //4 bytes float
+        cout << sizeof(double) << endl; //8 bytes double (有小數點預設用double存)
+        cout << sizeof(int) << endl;    //4 bytes int (可表正負2^31以內的數，超過會overflow
+        // 可用unsigned int存到2^32的數但只有正號)
+    }
     
     //int*、double*、char* 的sizeof()對於64bits的電腦來說都為8，指儲存的記憶體位址所用的16進位整數
     //不過pointer實際佔幾個記憶體空間看的是指向的資料型態本身 ex: int* 佔用4個bytes
@@ -91,6 +95,7 @@ int main() {
      std::cin.get();                //使用者按enter後才往後執行
      std::cin >> input;             //將使用者的輸入傳入input這個參數
      scanf("%d", &input);           //同上
+                                    //大量讀寫檔案時逐筆呼叫很慢，可整塊非同步讀寫 (見 topic/async io.cpp)
      
      %d：10 進位整數輸出
      %f：浮點數輸出
@@ -195,4 +200,5 @@ int main() {
      p=0; q=0; r=0; 都指回NULL比較保險
      
      */
+    TRACE_DUMP("trace.json");
 }
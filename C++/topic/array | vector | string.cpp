@@ -7,6 +7,8 @@
 #include <unordered_map>
 #include <list>
 #include <string>
+#include <cstring>
+#include "trace.h"   //編譯時加 -DTRACE 可記錄各段花費的時間 (見 trace.h)
 
 using namespace std;
 
@@ -27,18 +29,25 @@ int main() {
     for(int i=0; i<LEN; i++){
         a[i] = i * i;
     }
-    for(auto offset=begin(a); offset!=end(a); offset++){ //begin(a),end(a) are pointer
-        //cout << *offset << endl;
-    }
-    for(auto n:a){
-        //cout << n << endl;
+    {
+        TRACE_SCOPE("陣列 尋訪");
+        for(auto offset=begin(a); offset!=end(a); offset++){ //begin(a),end(a) are pointer
+            //cout << *offset << endl;
+        }
+        for(auto n:a){
+            //cout << n << endl;
+        }
     }
     
     //要 #include <algorithm>
-    sort(begin(a),end(a)); //小到大
-    reverse(begin(a), end(a)); //反轉
-    int* addr = find(begin(a), end(a), 4); //尋找數值(*addr)位址
-    //cout << (addr!=end(a)? "有":"沒有")<< endl; //若回傳end(a)則表示沒有該數值
+    {
+        TRACE_SCOPE("陣列 sort/reverse/find");
+        sort(begin(a),end(a)); //小到大
+        reverse(begin(a), end(a)); //反轉
+        int* addr = find(begin(a), end(a), 4); //尋找數值(*addr)位址
+        //常常要問某一段的和/最小值時，不要每次跑迴圈，可先建 Fenwick/segment tree (見 range query.cpp)
+        //cout << (addr!=end(a)? "有":"沒有")<< endl; //若回傳end(a)則表示沒有該數值
+    }
 
     
     //###################################
@@ -54,13 +63,16 @@ int main() {
     for(int i=0; i<b.size(); i++){ //可直接知道大小
         b[i] = i * i;
     }
-    for(array<int,LEN>::iterator it = b.begin(); //b.begin(),b.end() are iterator
-        it != b.end();
-        it++){
-        //cout << *it << endl;
-    }
-    for(auto n:b){
-       // cout << n << endl;
+    {
+        TRACE_SCOPE("array 尋訪");
+        for(array<int,LEN>::iterator it = b.begin(); //b.begin(),b.end() are iterator
+            it != b.end();
+            it++){
+            //cout << *it << endl;
+        }
+        for(auto n:b){
+           // cout << n << endl;
+        }
     }
     
     //b.size();  可直接知道大小
@@ -70,11 +82,15 @@ int main() {
     //b.back();  最後一個元素
     
     //要 #include <algorithm>
-    sort(b.begin(),b.end());
-    reverse(b.begin(),b.end());
-    array<int, LEN>::iterator it;
-    it = find(b.begin(), b.end(), 4); //尋找數值(*it)位址
-    //cout << (it!=b.end()? "有":"沒有")<< endl; //若回傳b.end()則表示沒有該數值
+    {
+        TRACE_SCOPE("array sort/reverse/find");
+        sort(b.begin(),b.end());
+        reverse(b.begin(),b.end());
+        array<int, LEN>::iterator it;
+        it = find(b.begin(), b.end(), 4); //尋找數值(*it)位址
+        //cout << (it!=b.end()? "有":"沒有")<< endl; //若回傳b.end()則表示沒有該數值
+        (void)it; //上一行的 cout 註解掉了，it 沒被讀取，這樣寫可避免 unused 警告
+    }
     
     
     
@@ -86,19 +102,23 @@ int main() {
     //再沒有using namespace std;下要寫為std::vector <int> c;
     
     vector <int> c = {5,4,3,2,1}; //initialize
+    //元素很少的 vector 也會配置一次 heap，大量短 list 可改用 SmallVector (見 small vector.cpp)
     // vector <int> c;
     // vector <int> c(LEN,10);    //LEN=3為{10,10,10}，就算LEN為var也可初始化
     
     for(int i=0; i<c.size(); i++){ //可直接知道大小
         //cout << c[i] << endl;
     }
-    for(vector<int>::iterator it = c.begin();
-        it != c.end();
-        it++){
-        // cout << *it << endl;
-    }
-    for(auto n:c){
-        //cout << n << endl;
+    {
+        TRACE_SCOPE("vector 尋訪");
+        for(vector<int>::iterator it = c.begin();
+            it != c.end();
+            it++){
+            // cout << *it << endl;
+        }
+        for(auto n:c){
+            //cout << n << endl;
+        }
     }
     
     //c.size();              可直接知道大小
@@ -112,11 +132,14 @@ int main() {
     //c.clear();             清空元素
     
     //要 #include <algorithm>
-    sort(c.begin(),c.end());
-    reverse(c.begin(),c.end());
-    vector<int>::iterator itt;
-    itt = find(c.begin(), c.end(), 4); //尋找數值(*itt)位址
-    //cout << (itt!=c.end()? "有":"沒有")<< endl; //若回傳c.end()則表示沒有該數值
+    {
+        TRACE_SCOPE("vector sort/reverse/find");
+        sort(c.begin(),c.end());   //大量整數、float 或 key/value 排序可改用 radix sort (見 radix sort.cpp)
+        reverse(c.begin(),c.end());
+        vector<int>::iterator itt;
+        itt = find(c.begin(), c.end(), 4); //尋找數值(*itt)位址
+        //cout << (itt!=c.end()? "有":"沒有")<< endl; //若回傳c.end()則表示沒有該數值
+    }
     
     //###################################
     //############### List ##############
@@ -128,13 +151,16 @@ int main() {
     list <int> d={1,2,3,4,5}; //initialize
     //list <int> d;
     
-    for(list<int>::iterator it = d.begin();
-        it != d.end();
-        it++){
-        // cout << *it << endl;
-    }
-    for(auto n:c){
-        // cout << n << endl;
+    {
+        TRACE_SCOPE("list 尋訪");
+        for(list<int>::iterator it = d.begin();
+            it != d.end();
+            it++){
+            // cout << *it << endl;
+        }
+        for(auto n:c){
+            // cout << n << endl;
+        }
     }
     
     //d.size();              可直接知道大小
@@ -150,11 +176,14 @@ int main() {
     //d.clear();             清空元素
     
     //要 #include <algorithm>
-    d.sort();
-    d.reverse();
-    list<int>::iterator ittt;
-    ittt = find(d.begin(), d.end(), 4); //尋找數值(*ittt)位址
-    // cout << (ittt!=d.end()? "有":"沒有")<< endl; //若回傳d.end()則表示沒有該數值
+    {
+        TRACE_SCOPE("list sort/reverse/find");
+        d.sort();
+        d.reverse();
+        list<int>::iterator ittt;
+        ittt = find(d.begin(), d.end(), 4); //尋找數值(*ittt)位址
+        // cout << (ittt!=d.end()? "有":"沒有")<< endl; //若回傳d.end()則表示沒有該數值
+    }
     
     //###################################
     //############### Set ###############
@@ -167,23 +196,31 @@ int main() {
     int arr_Set[] = {75,24,65,42,13,13};
     set<int> e (arr_Set, arr_Set+6);
     
-    for (set<int>::iterator it=e.begin();
-         it!=e.end(); 
-         ++it){ 
-        // 為紅黑樹演算法，會由小到大尋訪
-        // set 內只有一個 13，所以 e.size()為 5
-        // cout << *it << endl;
+    {
+        TRACE_SCOPE("set 尋訪");
+        for (set<int>::iterator it=e.begin();
+             it!=e.end(); 
+             ++it){ 
+            // 為紅黑樹演算法，會由小到大尋訪
+            // set 內只有一個 13，所以 e.size()為 5
+            // 每個 node 約 40 bytes，大量排序好的 ID 可改用壓縮的表示法 (見 compressed set.cpp)
+            // cout << *it << endl;
+        }
     }
     
     // e.size();     可直接知道大小
     // e.insert(i);  加入i這個數值  
     // e.empty();    是否有元素
     // e.count(i);   數i這個數值出現次數，只會有0,1
+    //               大部分查詢都找不到時，可先用 Bloom/Cuckoo filter 擋掉 (見 bloom filter.cpp)
     // e.erase(i);   將i這個數值刪除，i也可以是iterator
     
-    set<int>::iterator it_set;
-    it_set = e.find(13); //尋找數值(*it_set)位址
-    // cout << (it_set!=e.end()? "有":"沒有")<< endl; //若回傳e.end()則表示沒有該數值
+    {
+        TRACE_SCOPE("set find");
+        set<int>::iterator it_set;
+        it_set = e.find(13); //尋找數值(*it_set)位址
+        // cout << (it_set!=e.end()? "有":"沒有")<< endl; //若回傳e.end()則表示沒有該數值
+    }
     
     //###################################
     //############### Map ###############
@@ -195,15 +232,18 @@ int main() {
     map<int, string> f;
     
     // 可用下面兩種方式加入 key 和 value
-    f[5] = "first_value";
+    f[5] = "first_value";   //同樣的字串大量重複時，可只存一份、value 改存 4 bytes 的編號 (見 string intern.cpp)
     f.insert(pair<int, string>(10, "second_value"));
     
-    for (map<int,string>::iterator it=f.begin();
-         it!=f.end(); 
-         ++it){ 
-        // 為紅黑樹演算法尋訪
-        // it->first (key) it->second (value)
-        // cout << it->first << "\t" << it->second << endl;
+    {
+        TRACE_SCOPE("map 尋訪");
+        for (map<int,string>::iterator it=f.begin();
+             it!=f.end(); 
+             ++it){ 
+            // 為紅黑樹演算法尋訪
+            // it->first (key) it->second (value)
+            // cout << it->first << "\t" << it->second << endl;
+        }
     }
     
     // f.size();     可直接知道大小
@@ -211,9 +251,12 @@ int main() {
     // f.count(i);   數i這個數值出現次數，只會有0,1
     // f.erase(i);   將i這個key刪除，i也可以是iterator
     
-    map<int,string>::iterator it_map;
-    it_map = f.find(5); //尋找數值(*it_map)位址
-    // cout << (it_map!=f.end()? "有":"沒有")<< endl; //若回傳f.end()則表示沒有該數值
+    {
+        TRACE_SCOPE("map find");
+        map<int,string>::iterator it_map;
+        it_map = f.find(5); //尋找數值(*it_map)位址
+        // cout << (it_map!=f.end()? "有":"沒有")<< endl; //若回傳f.end()則表示沒有該數值
+    }
     
     //###################################
     //############ Hash Map #############
@@ -228,12 +271,15 @@ int main() {
     g[5] = 50;
     g.insert(pair<int, int>(10, 100));
     
-    for (unordered_map<int, int>::iterator it=g.begin();
-         it!=g.end(); 
-         ++it){ 
-        // 為紅黑樹演算法尋訪
-        // it->first (key) it->second (value)
-        // cout << it->first << "\t" << it->second << endl;
+    {
+        TRACE_SCOPE("hash map 尋訪");
+        for (unordered_map<int, int>::iterator it=g.begin();
+             it!=g.end(); 
+             ++it){ 
+            // 為紅黑樹演算法尋訪
+            // it->first (key) it->second (value)
+            // cout << it->first << "\t" << it->second << endl;
+        }
     }
     
     // g.size();     可直接知道大小
@@ -241,9 +287,12 @@ int main() {
     // g.count(i);   數i這個key出現次數，只會有0,1
     // g.erase(i);   將i這個key刪除，i也可以是iterator
     
-    unordered_map<int, int>::iterator it_hash;
-    it_hash = g.find(10); //尋找數值(*it_hash)位址
-    // cout << (it_hash!=g.end()? "有":"沒有")<< endl; //若回傳g.end()則表示沒有該數值
+    {
+        TRACE_SCOPE("hash map find");
+        unordered_map<int, int>::iterator it_hash;
+        it_hash = g.find(10); //尋找數值(*it_hash)位址
+        // cout << (it_hash!=g.end()? "有":"沒有")<< endl; //若回傳g.end()則表示沒有該數值
+    }
     
     //###################################
     //############# 多維陣列 #############
@@ -259,24 +308,27 @@ int main() {
                         {4, 5, 6}
                      };
     
-    for(int row = 0; row < R; row++) {
-        for(int col = 0; col < C; col++) {
-            //cout << maze[row][col] << "\t";
+    {
+        TRACE_SCOPE("多維陣列 尋訪");
+        for(int row = 0; row < R; row++) {
+            for(int col = 0; col < C; col++) {
+                //cout << maze[row][col] << "\t";
+            }
+            //cout << endl;
         }
-        //cout << endl;
+        for(auto row : maze) {
+            for(int i = 0; i < 3; i++) {
+                //cout << row[i] << "\t"; 
+            }
+            //cout << endl;
+        } 
+        for(auto &row : maze) {
+            for(auto n : row) {
+                //cout << n << "\t"; 
+            }
+            //cout << endl;
+        } 
     }
-    for(auto row : maze) {
-        for(int i = 0; i < 3; i++) {
-            //cout << row[i] << "\t"; 
-        }
-        //cout << endl;
-    } 
-    for(auto &row : maze) {
-        for(auto n : row) {
-            //cout << n << "\t"; 
-        }
-        //cout << endl;
-    } 
     
     //###################################
     //############# 多維Array ############
@@ -296,14 +348,18 @@ int main() {
                              }; 
     
     vector<vector<int>> vec( 2 , vector<int> (3, 0));  //產生一個2*3的vector並初始化為0
+    //大部分都是0的矩陣可只存非零的格子 (CSR/COO，見 sparse matrix.cpp)
     int Rv = vec.size();    //Row為2
     int Cv = vec[0].size(); //Col為3
     
-    for (int i = 0; i < vect.size(); i++) {      //vect.size()為row大小
-        for (int j = 0; j < vect[i].size(); j++) //vect[i].size()為column大小 
-            // cout << vect[i][j] << " "; 
-        cout << endl; 
-    } 
+    {
+        TRACE_SCOPE("多維vector 尋訪");
+        for (int i = 0; i < vect.size(); i++) {      //vect.size()為row大小
+            for (int j = 0; j < vect[i].size(); j++) //vect[i].size()為column大小 
+                // cout << vect[i][j] << " "; 
+            cout << endl; 
+        } 
+    }
         
     
     //###################################
@@ -399,4 +455,5 @@ int main() {
     void(int A[][3], array <array<int,3>,2> &B, vector<vector<int>> &C);
     
     */
+    TRACE_DUMP("trace.json");   //輸出給 chrome://tracing 或 ui.perfetto.dev 看
 }
\ No newline at end of file
@@ -0,0 +1,447 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <string>
+#include <chrono>
+#include <coroutine>     // C++20，編譯要加 -std=c++20
+#include <stdexcept>
+#include <charconv>      // to_chars
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>       // open (POSIX)
+#include <unistd.h>
+#include <sys/uio.h>     // preadv / pwritev
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>   // 只用 kernel 的 header，直接呼叫 system call，不需要 liburing
+
+using namespace std;
+
+//###################################
+//############# Async I/O ###########
+//###################################
+
+// cin >> input、scanf、cout、printf 每次呼叫都可能卡在 read()/write() 這個 system call 上
+// 讀寫大檔案時，CPU 在等磁碟，磁碟又在等 CPU 解析完才收到下一個請求
+//
+// io_uring (Linux 5.1+)：user space 和 kernel 共用兩個 ring buffer
+//   SQ (submission queue): 程式把「要讀哪個檔、讀到哪裡」寫進去，一次 io_uring_enter 可以送出很多筆
+//   CQ (completion queue): kernel 做完後把結果放進來，程式自己去拿
+// 送出之後程式可以繼續做別的事 (例如解析上一塊資料)，I/O 和計算就重疊了
+//
+// registered buffers：事先把 buffer 登記給 kernel (IORING_REGISTER_BUFFERS)
+//   之後 READ_FIXED/WRITE_FIXED 不用每次都重新 pin 住這塊記憶體
+//
+// 沒有 io_uring (舊 kernel、container 的 seccomp 擋掉) 時退回 preadv/pwritev：
+//   一樣先收集請求，同一個檔案、位置相連的請求合併成一次 system call，但是會 block
+//
+// C++20 coroutine 讓非同步的程式寫起來像一般的循序程式：
+//   Task parse(IoContext& io) {
+//       int n = co_await io.read_chunk(fd, buf, len, offset);   // 在這裡暫停，讀完才從這裡繼續
+//   }
+// 請求在建立時就排進佇列 (還沒送出)，在 co_await 暫停或呼叫 io.submit() 時整批送出
+// 所以可以先發出下一塊的讀取、submit()、解析目前這塊，最後再 co_await 下一塊
+
+class IoContext;
+
+// 一個讀/寫請求，建立後不能搬移 (佇列裡存的是它的位址)，要在 co_await 或解構前保持存活
+class IoOp {
+public:
+    enum Kind { READ, WRITE };
+
+    IoOp(IoContext& io, Kind kind, int fd, void* buf, size_t len, off_t off, int buf_index = -1);
+    IoOp(const IoOp&) = delete;
+    IoOp& operator=(const IoOp&) = delete;
+    ~IoOp();   // 還沒完成就等到完成，避免 kernel 寫進已經釋放的記憶體
+
+    // co_await 的三個介面
+    bool await_ready() const { return done_; }
+    void await_suspend(coroutine_handle<> h);
+    int await_resume() const { return result_; }   // 讀寫的 byte 數，錯誤時為 -errno
+
+private:
+    friend class IoContext;
+    IoContext& io_;
+    Kind kind_;
+    int fd_;
+    iovec iov_;
+    off_t off_;
+    int buf_index_;               // registered buffer 的編號，-1 表示一般 buffer
+    bool done_ = false;
+    int result_ = 0;
+    coroutine_handle<> waiter_;   // 正在等這個請求的 coroutine
+};
+
+// 最簡單的 coroutine 型態：建立後馬上執行，結束後自己釋放
+struct Task {
+    struct promise_type {
+        Task get_return_object() { return {}; }
+        suspend_never initial_suspend() { return {}; }
+        suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+    };
+};
+
+class IoContext {
+public:
+    // entries: SQ 的大小，也就是最多同時有幾個請求在 kernel 裡
+    explicit IoContext(unsigned entries = 256, bool try_uring = true) {
+        if (try_uring) setup_uring(entries);
+    }
+    ~IoContext() {
+        if (ring_fd_ < 0) return;
+        munmap(sqes_, sqes_size_);
+        if (cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_size_);
+        munmap(sq_ptr_, sq_size_);
+        close(ring_fd_);
+    }
+    IoContext(const IoContext&) = delete;
+    IoContext& operator=(const IoContext&) = delete;
+
+    bool using_uring() const { return ring_fd_ >= 0; }
+
+    // 登記 registered buffers，之後用 read_fixed/write_fixed(編號) 讀寫
+    void register_buffers(const vector<iovec>& bufs) {
+        bufs_ = bufs;
+        if (using_uring() && syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, bufs_.data(), unsigned(bufs_.size())) < 0)
+            throw runtime_error(string("IORING_REGISTER_BUFFERS: ") + strerror(errno));
+    }
+
+    IoOp read_chunk(int fd, void* buf, size_t len, off_t off) { return IoOp(*this, IoOp::READ, fd, buf, len, off); }
+    IoOp write_buffer(int fd, const void* buf, size_t len, off_t off) { return IoOp(*this, IoOp::WRITE, fd, const_cast<void*>(buf), len, off); }
+    IoOp read_fixed(int fd, int index, size_t len, off_t off) { return IoOp(*this, IoOp::READ, fd, bufs_.at(index).iov_base, len, off, index); }
+    IoOp write_fixed(int fd, int index, size_t len, off_t off) { return IoOp(*this, IoOp::WRITE, fd, bufs_.at(index).iov_base, len, off, index); }
+
+    // 把佇列裡的請求整批送出 (不等待完成)
+    void submit() {
+        if (using_uring()) submit_uring();
+        else run_fallback();
+    }
+
+    // 執行到所有 coroutine 都結束、所有請求都完成
+    void run() {
+        while (true) {
+            while (!ready_.empty()) {
+                coroutine_handle<> h = ready_.front();
+                ready_.pop_front();
+                h.resume();   // 可能又發出新的請求
+            }
+            if (pending_.empty() && inflight_ == 0 && unsubmitted_ == 0) break;
+            submit();
+            reap(true);
+        }
+    }
+
+    size_t syscalls() const { return syscalls_; }   // 統計：送出請求用了幾次 system call
+
+private:
+    friend class IoOp;
+    deque<IoOp*> pending_;            // 還沒送出的請求
+    deque<coroutine_handle<>> ready_; // 請求完成、可以繼續執行的 coroutine
+    size_t inflight_ = 0;             // 已經送進 kernel 還沒完成的請求數
+    unsigned unsubmitted_ = 0;        // 已經寫進 SQ ring、但 kernel 還沒取走的請求數 (io_uring_enter 可能只取一部分)
+    size_t syscalls_ = 0;
+    vector<iovec> bufs_;
+
+    void enqueue(IoOp* op) { pending_.push_back(op); }
+
+    void complete(IoOp* op, int res) {
+        op->result_ = res;
+        op->done_ = true;
+        if (op->waiter_) ready_.push_back(op->waiter_);
+    }
+
+    // 等到 op 完成 (解構時用)，完成的其他 coroutine 留給 run() 繼續
+    void wait_for(IoOp* op) {
+        while (!op->done_) {
+            submit();
+            reap(true);
+        }
+    }
+
+    //---------------- fallback: preadv / pwritev ----------------
+    void run_fallback() {
+        while (!pending_.empty()) {
+            // 同一個 fd、同方向、位置相連的請求合併成一次 preadv/pwritev
+            vector<IoOp*> batch{pending_.front()};
+            pending_.pop_front();
+            while (!pending_.empty() && batch.size() < IOV_MAX) {
+                IoOp* last = batch.back();
+                IoOp* next = pending_.front();
+                if (next->fd_ != last->fd_ || next->kind_ != last->kind_ ||
+                    next->off_ != last->off_ + off_t(last->iov_.iov_len)) break;
+                batch.push_back(next);
+                pending_.pop_front();
+            }
+            vector<iovec> iov;
+            for (IoOp* op : batch) iov.push_back(op->iov_);
+            ssize_t n = batch[0]->kind_ == IoOp::READ
+                ? preadv(batch[0]->fd_, iov.data(), int(iov.size()), batch[0]->off_)
+                : pwritev(batch[0]->fd_, iov.data(), int(iov.size()), batch[0]->off_);
+            syscalls_++;
+            int err = n < 0 ? -errno : 0;
+            for (IoOp* op : batch) {   // 讀到檔案結尾時前面的請求拿滿，後面的拿剩下的
+                if (err) { complete(op, err); continue; }
+                size_t got = min<size_t>(size_t(n), op->iov_.iov_len);
+                complete(op, int(got));
+                n -= ssize_t(got);
+            }
+        }
+    }
+
+    //---------------- io_uring ----------------
+    int ring_fd_ = -1;
+    void *sq_ptr_ = nullptr, *cq_ptr_ = nullptr;
+    size_t sq_size_ = 0, cq_size_ = 0, sqes_size_ = 0;
+    unsigned *sq_head_, *sq_tail_, *sq_mask_, *sq_array_, *cq_head_, *cq_tail_, *cq_mask_;
+    unsigned sq_entries_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+
+    void setup_uring(unsigned entries) {
+        io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        int fd = int(syscall(__NR_io_uring_setup, entries, &p));
+        if (fd < 0) return;   // ENOSYS / EPERM：不支援，用 fallback
+
+        sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single = p.features & IORING_FEAT_SINGLE_MMAP;   // 新 kernel 的 SQ、CQ ring 在同一塊
+        if (single) sq_size_ = cq_size_ = max(sq_size_, cq_size_);
+        sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sq_ptr_ == MAP_FAILED) { close(fd); return; }
+        cq_ptr_ = single ? sq_ptr_ : mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (cq_ptr_ == MAP_FAILED || sqes == MAP_FAILED) {
+            if (cq_ptr_ != MAP_FAILED && !single) munmap(cq_ptr_, cq_size_);
+            if (sqes != MAP_FAILED) munmap(sqes, sqes_size_);
+            munmap(sq_ptr_, sq_size_);
+            close(fd);
+            return;
+        }
+
+        char* sq = static_cast<char*>(sq_ptr_);
+        char* cq = static_cast<char*>(cq_ptr_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sq_mask_ = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cq_mask_ = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+        sq_entries_ = p.sq_entries;
+        ring_fd_ = fd;
+    }
+
+    // ring 的 head/tail 和 kernel 共用，要用 acquire/release 讀寫
+    static unsigned load_acquire(unsigned* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+    static void store_release(unsigned* p, unsigned v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+
+    void submit_uring() {
+        while (!pending_.empty() || unsubmitted_ > 0) {
+            unsigned tail = *sq_tail_, head = load_acquire(sq_head_);
+            unsigned n = 0;
+            while (!pending_.empty() && tail - head < sq_entries_ &&
+                   inflight_ + unsubmitted_ + n < sq_entries_) {   // CQ 至少和 SQ 一樣大，這樣 CQ 不會滿
+                IoOp* op = pending_.front();
+                pending_.pop_front();
+                unsigned idx = tail & *sq_mask_;
+                io_uring_sqe* sqe = &sqes_[idx];
+                memset(sqe, 0, sizeof(*sqe));
+                sqe->fd = op->fd_;
+                sqe->off = uint64_t(op->off_);
+                sqe->user_data = reinterpret_cast<uint64_t>(op);
+                if (op->buf_index_ >= 0) {
+                    sqe->opcode = op->kind_ == IoOp::READ ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+                    sqe->addr = reinterpret_cast<uint64_t>(op->iov_.iov_base);
+                    sqe->len = unsigned(op->iov_.iov_len);
+                    sqe->buf_index = uint16_t(op->buf_index_);
+                } else {
+                    sqe->opcode = op->kind_ == IoOp::READ ? IORING_OP_READV : IORING_OP_WRITEV;
+                    sqe->addr = reinterpret_cast<uint64_t>(&op->iov_);
+                    sqe->len = 1;
+                }
+                sq_array_[idx] = idx;
+                tail++;
+                n++;
+            }
+            if (n == 0 && unsubmitted_ == 0) { reap(true); continue; }   // 佇列滿了，先等一些請求完成
+            store_release(sq_tail_, tail);
+            unsubmitted_ += n;
+            if (enter(0, 0) == 0) {
+                // kernel 暫時收不下 (EAGAIN/EBUSY 或一筆都沒取走)：等一些完成再送剩下的
+                if (inflight_ == 0) throw runtime_error("io_uring_enter: kernel 沒有取走任何請求");
+                reap(true);
+            }
+        }
+    }
+
+    // 送出 SQ ring 裡還沒被取走的請求，順便等 min_complete 個完成
+    // 回傳值是 kernel 這次實際取走的 SQE 數，可能比 to_submit 少，剩下的留在 ring 裡下次再送
+    unsigned enter(unsigned min_complete, unsigned flags) {
+        int r;
+        do {
+            r = int(syscall(__NR_io_uring_enter, ring_fd_, unsubmitted_, min_complete, flags, nullptr, 0));
+        } while (r < 0 && errno == EINTR);
+        syscalls_++;
+        if (r < 0) {
+            if (errno == EAGAIN || errno == EBUSY) return 0;
+            throw runtime_error(string("io_uring_enter: ") + strerror(errno));
+        }
+        inflight_ += unsigned(r);
+        unsubmitted_ -= unsigned(r);
+        return unsigned(r);
+    }
+
+    // 收完成的結果；wait 為 true 時至少等到一個
+    void reap(bool wait) {
+        if (ring_fd_ < 0 || (inflight_ == 0 && unsubmitted_ == 0)) return;
+        unsigned head = *cq_head_;
+        if (wait && head == load_acquire(cq_tail_)) {
+            // 還留在 SQ ring 的請求要先送出去；一筆都沒進 kernel 時不能等，否則永遠等不到完成
+            if (unsubmitted_ > 0) enter(0, 0);
+            if (inflight_ > 0) enter(1, IORING_ENTER_GETEVENTS);
+        }
+        unsigned tail = load_acquire(cq_tail_);
+        for (; head != tail; head++) {
+            io_uring_cqe* cqe = &cqes_[head & *cq_mask_];
+            complete(reinterpret_cast<IoOp*>(cqe->user_data), cqe->res);
+            inflight_--;
+        }
+        store_release(cq_head_, head);
+    }
+};
+
+IoOp::IoOp(IoContext& io, Kind kind, int fd, void* buf, size_t len, off_t off, int buf_index)
+    : io_(io), kind_(kind), fd_(fd), iov_{buf, len}, off_(off), buf_index_(buf_index) {
+    io_.enqueue(this);
+}
+
+IoOp::~IoOp() {
+    if (!done_) io_.wait_for(this);
+}
+
+void IoOp::await_suspend(coroutine_handle<> h) {
+    waiter_ = h;
+    io_.submit();   // 暫停前把累積的請求送出去
+}
+
+//###################################
+//############ Benchmark ############
+//###################################
+
+const size_t CHUNK = 1 << 20;   // 每次讀寫 1MB
+
+// 把 [i, n) 的數字每行一個格式化進 buf，最多約 CHUNK bytes，回傳長度
+size_t format_numbers(char* buf, long long& i, long long n) {
+    size_t len = 0;
+    while (i < n && len < CHUNK) {
+        char* e = to_chars(buf + len, buf + len + 31, i++).ptr;   // 比 snprintf 快很多，不用解析格式字串
+        *e++ = '\n';
+        len = size_t(e - buf);
+    }
+    return len;
+}
+
+// 寫出 0..n-1：上一塊在寫的時候格式化下一塊，兩個 buffer 輪流用
+Task dump_numbers(IoContext& io, int fd, long long n, bool* ok) {
+    vector<char> buf[2] = {vector<char>(CHUNK + 32), vector<char>(CHUNK + 32)};
+    long long i = 0;
+    off_t off = 0;
+    int cur = 0;
+    size_t len = format_numbers(buf[cur].data(), i, n);
+    *ok = true;
+    while (len > 0) {
+        IoOp w = io.write_buffer(fd, buf[cur].data(), len, off);   // 回傳值直接建在 w 上 (C++17 保證不複製)
+        io.submit();
+        off += off_t(len);
+        size_t written = len;
+        cur ^= 1;
+        len = format_numbers(buf[cur].data(), i, n);   // 和上面的寫入重疊
+        if (co_await w != int(written)) *ok = false;   // 等寫完，這個 buffer 下一輪才能重用
+    }
+}
+
+// 解析一塊資料裡的整數，數字被切在兩塊中間時 partial 保留前半
+void parse_chunk(const char* p, size_t n, long long& partial, bool& in_num, long long& sum) {
+    for (size_t k = 0; k < n; k++) {
+        char ch = p[k];
+        if (ch >= '0' && ch <= '9') { partial = partial * 10 + (ch - '0'); in_num = true; }
+        else if (in_num) { sum += partial; partial = 0; in_num = false; }
+    }
+}
+
+// 用 registered buffer 0/1 輪流讀：下一塊在讀的時候解析這一塊
+Task sum_numbers(IoContext& io, int fd, char* const bufs[2], long long* result) {
+    long long sum = 0, partial = 0;
+    bool in_num = false;
+    int cur = 0;
+    off_t off = 0;
+    int n = co_await io.read_fixed(fd, cur, CHUNK, off);
+    while (n > 0) {
+        off += n;
+        IoOp next = io.read_fixed(fd, cur ^ 1, CHUNK, off);   // 先發出下一塊
+        io.submit();
+        parse_chunk(bufs[cur], size_t(n), partial, in_num, sum);
+        cur ^= 1;
+        n = co_await next;
+    }
+    if (in_num) sum += partial;
+    *result = n < 0 ? -1 : sum;
+}
+
+template <class F>
+double time_ms(F fn) {
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    // 用法：./asyncio [N]   編譯：g++ -O2 -std=c++20 "async io.cpp"
+    long long N = argc > 1 ? stoll(argv[1]) : 5000000;
+    const char* path = "/tmp/code-notes-io.txt";
+    long long expect = N * (N - 1) / 2;
+
+    // 對照組：一個一個寫 / 讀
+    double t_out = time_ms([&]{ ofstream out(path); for (long long i = 0; i < N; i++) out << i << '\n'; });
+    long long s_in = 0;
+    double t_in = time_ms([&]{ ifstream in(path); long long x; while (in >> x) s_in += x; });
+    long long s_scanf = 0;
+    double t_scanf = time_ms([&]{ FILE* f = fopen(path, "r"); long long x; while (fscanf(f, "%lld", &x) == 1) s_scanf += x; fclose(f); });
+    printf("N = %lld\n", N);
+    printf("ofstream <<        寫 %7.1f ms\n", t_out);
+    printf("ifstream >>        讀 %7.1f ms  %s\n", t_in, s_in == expect ? "結果相同" : "結果錯誤!");
+    printf("fscanf             讀 %7.1f ms  %s\n", t_scanf, s_scanf == expect ? "結果相同" : "結果錯誤!");
+
+    for (bool uring : {true, false}) {
+        IoContext io(64, uring);
+        if (uring && !io.using_uring()) { printf("io_uring 無法使用，略過\n"); continue; }
+        const char* name = io.using_uring() ? "io_uring" : "preadv/pwritev";
+
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        bool ok = false;
+        double t_w = time_ms([&]{ dump_numbers(io, fd, N, &ok); io.run(); });
+        close(fd);
+
+        vector<char> b0(CHUNK), b1(CHUNK);
+        char* const bufs[2] = {b0.data(), b1.data()};
+        io.register_buffers({iovec{bufs[0], CHUNK}, iovec{bufs[1], CHUNK}});
+        fd = open(path, O_RDONLY);
+        long long s = 0;
+        size_t before = io.syscalls();
+        double t_r = time_ms([&]{ sum_numbers(io, fd, bufs, &s); io.run(); });
+        close(fd);
+        printf("%-18s 寫 %7.1f ms  讀 %7.1f ms (%zu 次 system call)  %s\n", name, t_w, t_r,
+               io.syscalls() - before, (ok && s == expect) ? "結果相同" : "結果錯誤!");
+    }
+}
@@ -0,0 +1,509 @@
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>      // mkstemp
+#include <type_traits>
+#include <sys/mman.h>   // mmap (POSIX)
+#include <sys/stat.h>
+#include <unistd.h>     // unlink、write、close (POSIX)
+
+using namespace std;
+
+//###################################
+//######## Binary Serialization #####
+//###################################
+
+// 用 cout << a << ' ' << b; 存成文字，讀回來要 >> 逐個解析、重新 new 物件，又慢又大
+// 直接把物件的記憶體 write 出去也不行：int* b 這種 pointer 換一個程式執行就指到別的地方了
+//
+// 這裡的做法 (類似 FlatBuffers)：
+//   1. 所有資料寫在一整塊 buffer 裡，pointer 改存「目標位置 - 自己位置」的相對 offset (int32)
+//      buffer 搬到哪裡 (檔案、網路、mmap) 相對位置都不變
+//   2. 每個 scalar 都對齊到自己的大小 (int32 對齊 4、double 對齊 8)，讀取就是一次普通的 load
+//   3. 讀的時候不解析、不配置記憶體，直接在 buffer 上讀 (zero-copy)
+//   4. 每個 table (物件) 開頭有一張欄位表：欄位編號 -> 在 table 內的 offset (0 表示沒有這個欄位)
+//      新版本只能在後面加欄位：舊程式讀新資料會忽略不認得的欄位，新程式讀舊資料則拿到預設值
+//
+// buffer 格式：
+//   [Header 16 bytes][... strings / vectors / tables ...]
+//   table:  [uint16 欄位數][uint16 offset × 欄位數][欄位資料...]   (table 本身不超過 64KB，大資料放在外面用 ref 指過去)
+//   string: [uint32 長度][字元...]['\0']
+//   vector: [uint32 個數][uint32 保留][元素...]   (元素從 8 的倍數開始)
+// 位置用 uint32、相對 offset 用 int32，所以整個 buffer 最多 2GB，超過時 Builder 丟 length_error
+
+struct Header {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t root;   // root table 的位置
+    uint32_t size;   // 整個 buffer 的大小
+};
+
+//---------------- 寫入 ----------------
+
+class Builder {
+public:
+    Builder() { buf_.resize(sizeof(Header)); }
+
+    uint32_t add_string(string_view s) {
+        check_room(s.size() + 5);
+        uint32_t pos = put<uint32_t>(uint32_t(s.size()));
+        buf_.insert(buf_.end(), s.begin(), s.end());
+        buf_.push_back(0);   // 結尾補 '\0'，data() 也能當 C 字串用
+        return pos;
+    }
+
+    template <class T>
+    uint32_t add_vector(const T* p, size_t n) {
+        static_assert(is_arithmetic<T>::value, "vector 元素要是 scalar");
+        check_room(n * sizeof(T) + 16);
+        align(8);
+        uint32_t pos = size();
+        put<uint32_t>(uint32_t(n));
+        put<uint32_t>(0);
+        size_t at = buf_.size();
+        buf_.resize(at + n * sizeof(T));
+        if (n) memcpy(&buf_[at], p, n * sizeof(T));
+        return pos;
+    }
+    template <class T>
+    uint32_t add_vector(const vector<T>& v) { return add_vector(v.data(), v.size()); }
+
+    // 元素是 string / table 的 vector：每個元素存相對 offset
+    uint32_t add_ref_vector(const vector<uint32_t>& targets) {
+        check_room(targets.size() * 4 + 16);
+        align(8);
+        uint32_t pos = size();
+        put<uint32_t>(uint32_t(targets.size()));
+        put<uint32_t>(0);
+        for (uint32_t t : targets) put<int32_t>(int32_t(int64_t(t) - int64_t(size())));
+        return pos;
+    }
+
+    template <class T>
+    uint32_t add_scalar(T v) { return put<T>(v); }   // 單獨一個值，給 pointer 欄位指過去用
+
+    // 一次只能建一個 table：子物件 (string、vector、其他 table) 要先寫好，再開始寫父 table
+    class Table {
+    public:
+        template <class T>
+        void add(uint16_t id, T v) {
+            static_assert(is_arithmetic<T>::value, "欄位要是 scalar，其他資料請用 add_ref");
+            Field f{id, sizeof(T), false, 0, 0};
+            memcpy(&f.bits, &v, sizeof(T));
+            b_.fields_.push_back(f);
+        }
+        void add_ref(uint16_t id, uint32_t target) { b_.fields_.push_back(Field{id, 4, true, 0, target}); }
+
+        uint32_t finish() {
+            vector<Field>& fields = b_.fields_;
+            uint16_t n = 0;
+            for (auto& f : fields) n = max<uint16_t>(n, f.id + 1);
+            // 大的欄位先放，才不會浪費對齊的空間
+            stable_sort(fields.begin(), fields.end(), [](const Field& x, const Field& y) { return x.size > y.size; });
+
+            b_.check_room(2 + 2 * size_t(n) + 16 * fields.size());   // 欄位表 + 每個欄位最多 8 bytes 加上對齊
+            b_.align(8);
+            uint32_t start = b_.size();
+            b_.put<uint16_t>(n);
+            size_t slots = b_.buf_.size();
+            b_.buf_.resize(slots + 2 * size_t(n), 0);
+            for (auto& f : fields) {
+                b_.align(f.size);
+                uint32_t at = b_.size();
+                if (at - start > 0xFFFF) throw length_error("table 超過 64KB");
+                uint16_t rel = uint16_t(at - start);
+                memcpy(&b_.buf_[slots + 2 * f.id], &rel, 2);
+                if (f.is_ref) b_.put<int32_t>(int32_t(int64_t(f.target) - int64_t(at)));
+                else { b_.buf_.resize(at + f.size); memcpy(&b_.buf_[at], &f.bits, f.size); }
+            }
+            fields.clear();
+            return start;
+        }
+
+    private:
+        friend class Builder;
+        Builder& b_;
+        explicit Table(Builder& b) : b_(b) {}
+    };
+
+    Table start_table() { fields_.clear(); return Table(*this); }
+
+    // 寫好 header，回傳整個 buffer
+    vector<uint8_t> finish(uint32_t root, uint16_t version) {
+        check_room(0);
+        align(8);
+        Header h{{'C', 'N', 'B', '1'}, version, 0, root, size()};
+        memcpy(&buf_[0], &h, sizeof(h));
+        return std::move(buf_);
+    }
+
+private:
+    struct Field { uint16_t id; uint8_t size; bool is_ref; uint64_t bits; uint32_t target; };
+    vector<uint8_t> buf_;
+    vector<Field> fields_;   // 正在寫的 table 的欄位，重複使用避免每個 table 都配置記憶體
+
+    // 超過 2GB 時 uint32_t / int32_t 的轉換會悄悄截斷，讀回來變成「看起來合法」的錯誤 offset，所以寫入前就要擋下
+    static const size_t MAX_SIZE = INT32_MAX;
+    void check_room(size_t more) const {
+        if (more > MAX_SIZE || buf_.size() + 8 > MAX_SIZE - more) throw length_error("buffer 超過 2GB，offset 放不下");
+    }
+    uint32_t size() const { return uint32_t(buf_.size()); }   // 所有寫入都先經過 check_room，不會超過 MAX_SIZE
+    void align(size_t a) { buf_.resize((buf_.size() + a - 1) / a * a, 0); }
+    template <class T>
+    uint32_t put(T v) {
+        check_room(sizeof(T));
+        align(sizeof(T));
+        uint32_t pos = size();
+        buf_.resize(pos + sizeof(T));
+        memcpy(&buf_[pos], &v, sizeof(T));
+        return pos;
+    }
+};
+
+//---------------- 讀取 (zero-copy) ----------------
+
+// 收到的 buffer 可能是壞的，每次讀取都檢查範圍，錯了就丟 bad_buffer
+struct bad_buffer : runtime_error { using runtime_error::runtime_error; };
+
+class Span {   // buffer 和大小，所有 view 共用
+public:
+    Span(const uint8_t* p = nullptr, size_t n = 0) : p_(p), n_(n) {}
+    template <class T>
+    T read(size_t pos) const {
+        check(pos, sizeof(T));
+        T v;
+        memcpy(&v, p_ + pos, sizeof(T));   // 已經對齊，編譯器會變成一個 load
+        return v;
+    }
+    size_t deref(size_t pos) const { return size_t(int64_t(pos) + read<int32_t>(pos)); }   // 相對 offset -> 絕對位置
+    void check(size_t pos, size_t len) const { if (pos > n_ || len > n_ - pos) throw bad_buffer("buffer 越界"); }
+    // 要當成 T* 直接用的位置：除了範圍，還要檢查對齊 (壞掉的 offset 可能指到奇數位置，未對齊的 T* 是未定義行為)
+    template <class T>
+    void check_array(size_t pos, size_t count) const {
+        check(pos, count * sizeof(T));
+        if (reinterpret_cast<uintptr_t>(p_ + pos) % alignof(T)) throw bad_buffer("buffer 沒有對齊");
+    }
+    const uint8_t* at(size_t pos) const { return p_ + pos; }
+
+private:
+    const uint8_t* p_;
+    size_t n_;
+};
+
+template <class T>
+class VectorView {
+public:
+    VectorView() : n_(0), pos_(0) {}
+    VectorView(Span s, size_t pos) : s_(s), n_(s.read<uint32_t>(pos)), pos_(pos + 8) { s_.check_array<T>(pos_, n_); }
+    size_t size() const { return n_; }
+    T operator[](size_t i) const {
+        if (i >= n_) throw out_of_range("VectorView: index 越界");
+        T v;
+        memcpy(&v, s_.at(pos_ + i * sizeof(T)), sizeof(T));
+        return v;
+    }
+    const T* data() const { return reinterpret_cast<const T*>(s_.at(pos_)); }   // 建立時檢查過範圍和對齊，可以直接當陣列用
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + n_; }
+private:
+    Span s_;
+    size_t n_, pos_;
+};
+
+class TableView;
+
+class RefVectorView {
+public:
+    RefVectorView() : n_(0), pos_(0) {}
+    RefVectorView(Span s, size_t pos) : s_(s), n_(s.read<uint32_t>(pos)), pos_(pos + 8) { s_.check(pos_, n_ * 4); }
+    size_t size() const { return n_; }
+    string_view string_at(size_t i) const;
+    TableView table_at(size_t i) const;
+private:
+    Span s_;
+    size_t n_, pos_;
+};
+
+inline string_view read_string(Span s, size_t pos) {
+    uint32_t len = s.read<uint32_t>(pos);
+    s.check(pos + 4, len);
+    return string_view(reinterpret_cast<const char*>(s.at(pos + 4)), len);
+}
+
+class TableView {
+public:
+    TableView() : pos_(0), n_(0) {}
+    TableView(Span s, size_t pos) : s_(s), pos_(pos), n_(s.read<uint16_t>(pos)) { s_.check(pos, 2 + 2 * size_t(n_)); }
+
+    bool valid() const { return pos_ != 0; }
+    bool has(uint16_t id) const { return field(id) != 0; }
+
+    // 欄位不存在 (舊版資料) 就回傳預設值
+    template <class T>
+    T get(uint16_t id, T def = T()) const {
+        size_t f = field(id);
+        return f ? s_.read<T>(f) : def;
+    }
+    // pointer 欄位：沒有就回傳 nullptr，有就直接指向 buffer 裡的值
+    template <class T>
+    const T* get_ptr(uint16_t id) const {
+        size_t f = field(id);
+        if (!f) return nullptr;
+        size_t t = s_.deref(f);
+        s_.check_array<T>(t, 1);
+        return reinterpret_cast<const T*>(s_.at(t));
+    }
+    string_view get_string(uint16_t id) const { size_t f = field(id); return f ? read_string(s_, s_.deref(f)) : string_view(); }
+    template <class T>
+    VectorView<T> get_vector(uint16_t id) const { size_t f = field(id); return f ? VectorView<T>(s_, s_.deref(f)) : VectorView<T>(); }
+    RefVectorView get_ref_vector(uint16_t id) const { size_t f = field(id); return f ? RefVectorView(s_, s_.deref(f)) : RefVectorView(); }
+    TableView get_table(uint16_t id) const { size_t f = field(id); return f ? TableView(s_, s_.deref(f)) : TableView(); }
+
+private:
+    Span s_;
+    size_t pos_;
+    uint16_t n_;
+
+    size_t field(uint16_t id) const {
+        if (id >= n_) return 0;   // 新版才有的欄位
+        uint16_t off = s_.read<uint16_t>(pos_ + 2 + 2 * size_t(id));
+        return off ? pos_ + off : 0;
+    }
+};
+
+inline string_view RefVectorView::string_at(size_t i) const {
+    if (i >= n_) throw out_of_range("RefVectorView: index 越界");
+    return read_string(s_, s_.deref(pos_ + 4 * i));
+}
+inline TableView RefVectorView::table_at(size_t i) const {
+    if (i >= n_) throw out_of_range("RefVectorView: index 越界");
+    return TableView(s_, s_.deref(pos_ + 4 * i));
+}
+
+// 取得 root table，並檢查 header
+inline TableView open_buffer(const uint8_t* p, size_t n, uint16_t* version = nullptr) {
+    Span s(p, n);
+    Header h = s.read<Header>(0);
+    if (memcmp(h.magic, "CNB1", 4) != 0 || h.size > n) throw bad_buffer("不是這個格式的 buffer");
+    if (version) *version = h.version;
+    return TableView(s, h.root);
+}
+
+//###################################
+//############## Schema #############
+//###################################
+
+// 模仿 class.cpp 的 MyClass / MC 改寫前的成員 (int* b)，這裡全部放 public 方便示範
+// class.cpp 現在用 handle::CowBuffer<int> b 管理記憶體；這裡的 b 只是指向單一個 int 的不擁有 pointer，用來示範序列化參照
+struct MyClass {
+    int a = 0;
+    int* b = nullptr;   // 不擁有的 pointer
+    int c = 10;
+};
+struct MC : MyClass {
+    int d = 5;
+};
+
+// 欄位編號就是 schema：只能往後加，不能改已經用過的編號
+// version 1: a, b, c
+// version 2: 加了 d (MC)
+namespace MyClassField { enum : uint16_t { a, b, c, d }; }
+namespace DocField { enum : uint16_t { objects, map_keys, map_values, list }; }
+
+uint32_t write(Builder& B, const MC& m, int version) {
+    uint32_t b_target = m.b ? B.add_scalar<int32_t>(*m.b) : 0;   // b 指向的值另外存，欄位存相對 offset
+    auto t = B.start_table();
+    t.add<int32_t>(MyClassField::a, m.a);
+    if (m.b) t.add_ref(MyClassField::b, b_target);
+    t.add<int32_t>(MyClassField::c, m.c);
+    if (version >= 2) t.add<int32_t>(MyClassField::d, m.d);
+    return t.finish();
+}
+
+// 直接讀 buffer 的 view，不產生 MyClass 物件
+struct MCView {
+    TableView t;
+    int a() const { return t.get<int32_t>(MyClassField::a, 0); }
+    const int32_t* b() const { return t.get_ptr<int32_t>(MyClassField::b); }
+    int c() const { return t.get<int32_t>(MyClassField::c, 10); }
+    int d() const { return t.get<int32_t>(MyClassField::d, 5); }   // 舊版資料沒有 d，給 MC() 的預設值 5
+};
+
+// map<int,string>：key 排序好存成 int32 vector，value 存成 string 的 ref vector
+// 查詢在 buffer 上直接 binary search，不用先建一棵紅黑樹
+struct MapView {
+    VectorView<int32_t> keys;
+    RefVectorView values;
+    bool find(int key, string_view* out) const {
+        const int32_t* it = lower_bound(keys.begin(), keys.end(), key);
+        if (it == keys.end() || *it != key) return false;
+        *out = values.string_at(it - keys.begin());
+        return true;
+    }
+};
+
+struct Document {
+    vector<MC> objects;
+    map<int, string> f;
+    vector<int> c;
+};
+
+vector<uint8_t> encode(const Document& doc, int version = 2) {
+    Builder B;
+    vector<uint32_t> objs;
+    objs.reserve(doc.objects.size());
+    for (auto& m : doc.objects) objs.push_back(write(B, m, version));
+    uint32_t objects = B.add_ref_vector(objs);
+
+    vector<int32_t> keys;
+    vector<uint32_t> values;
+    for (auto& kv : doc.f) { keys.push_back(kv.first); values.push_back(B.add_string(kv.second)); }   // map 已經排好序
+    uint32_t k = B.add_vector(keys), v = B.add_ref_vector(values);
+    uint32_t list = B.add_vector(doc.c);
+
+    auto root = B.start_table();
+    root.add_ref(DocField::objects, objects);
+    root.add_ref(DocField::map_keys, k);
+    root.add_ref(DocField::map_values, v);
+    root.add_ref(DocField::list, list);
+    return B.finish(root.finish(), uint16_t(version));
+}
+
+//---------------- 文字格式 (對照組) ----------------
+
+string encode_text(const Document& doc) {
+    ostringstream os;
+    os << doc.objects.size() << '\n';
+    for (auto& m : doc.objects) os << m.a << ' ' << (m.b ? 1 : 0) << ' ' << (m.b ? *m.b : 0) << ' ' << m.c << ' ' << m.d << '\n';
+    os << doc.f.size() << '\n';
+    for (auto& kv : doc.f) os << kv.first << ' ' << kv.second << '\n';
+    os << doc.c.size() << '\n';
+    for (int x : doc.c) os << x << ' ';
+    return os.str();
+}
+
+// 讀回來要重新配置每個物件，b 指向的值也要 new 出來
+void decode_text(const string& s, Document& doc, vector<int>& b_storage) {
+    istringstream is(s);
+    size_t n;
+    is >> n;
+    doc.objects.resize(n);
+    b_storage.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        int has_b, bv;
+        MC& m = doc.objects[i];
+        is >> m.a >> has_b >> bv >> m.c >> m.d;
+        b_storage[i] = bv;
+        m.b = has_b ? &b_storage[i] : nullptr;
+    }
+    is >> n;
+    for (size_t i = 0; i < n; i++) { int k; string v; is >> k >> v; doc.f[k] = v; }
+    is >> n;
+    doc.c.resize(n);
+    for (auto& x : doc.c) is >> x;
+}
+
+//###################################
+//############ Benchmark ############
+//###################################
+
+template <class F>
+double time_ms(F fn) {
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    // 用法：./serialize [N]
+    size_t N = argc > 1 ? stoull(argv[1]) : 1000000;
+
+    Document doc;
+    vector<int> pointees(N);
+    doc.objects.resize(N);
+    for (size_t i = 0; i < N; i++) {
+        MC& m = doc.objects[i];
+        m.a = int(i);
+        pointees[i] = int(i * 7);
+        m.b = (i % 2) ? &pointees[i] : nullptr;
+        m.d = int(i % 100);
+        doc.f[int(i * 3)] = "value_" + to_string(i);
+        doc.c.push_back(int(N - i));
+    }
+
+    // 寫入，再從檔案 mmap 回來，直接在映射的記憶體上讀
+    vector<uint8_t> buf;
+    double t_enc = time_ms([&]{ buf = encode(doc); });
+    // mkstemp 建立一個不會和別人撞名的暫存檔 (XXXXXX 會被換掉)，mmap 之後就 unlink，程式結束時檔案自動消失
+    char path[] = "/tmp/code-notes-serialize-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) { perror("mkstemp"); return 1; }
+    unlink(path);   // 目錄裡的名字先刪掉，fd 和 mmap 還在用時資料不會消失
+    struct stat st;
+    if (write(fd, buf.data(), buf.size()) != ssize_t(buf.size()) || fstat(fd, &st) < 0) {
+        perror("write/fstat");
+        close(fd);
+        return 1;
+    }
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);   // 頁對齊，所以欄位的對齊也成立
+    close(fd);
+    if (mapped == MAP_FAILED) { perror("mmap"); return 1; }
+
+    long long sum_bin = 0;
+    double t_dec = time_ms([&]{
+        TableView root = open_buffer(static_cast<const uint8_t*>(mapped), st.st_size);
+        RefVectorView objs = root.get_ref_vector(DocField::objects);
+        for (size_t i = 0; i < objs.size(); i++) {
+            MCView m{objs.table_at(i)};
+            sum_bin += m.a() + m.c() + m.d() + (m.b() ? *m.b() : 0);
+        }
+        MapView mv{root.get_vector<int32_t>(DocField::map_keys), root.get_ref_vector(DocField::map_values)};
+        for (size_t i = 0; i < N; i += 1000) { string_view v; if (mv.find(int(i * 3), &v)) sum_bin += v.size(); }
+        for (int x : root.get_vector<int32_t>(DocField::list)) sum_bin += x;
+    });
+    munmap(mapped, st.st_size);
+
+    string text;
+    double t_tenc = time_ms([&]{ text = encode_text(doc); });
+    Document back;
+    vector<int> b_storage;
+    long long sum_txt = 0;
+    double t_tdec = time_ms([&]{
+        decode_text(text, back, b_storage);
+        for (auto& m : back.objects) sum_txt += m.a + m.c + m.d + (m.b ? *m.b : 0);
+        for (size_t i = 0; i < N; i += 1000) { auto it = back.f.find(int(i * 3)); if (it != back.f.end()) sum_txt += it->second.size(); }
+        for (int x : back.c) sum_txt += x;
+    });
+
+    // 小整數寫成文字只要幾個字元，binary 則是固定寬度再加上對齊和欄位表，所以檔案不一定比較小
+    // 換來的是讀取時不用解析、不用配置記憶體
+    printf("N = %zu 個 MC + map<int,string> + vector<int>\n", N);
+    printf("binary  %8.1f MB  encode %7.1f ms (%6.0f MB/s)  mmap + 讀取 %7.1f ms\n", buf.size() / 1e6, t_enc, buf.size() / 1e3 / t_enc, t_dec);
+    printf("text    %8.1f MB  encode %7.1f ms (%6.0f MB/s)  解析 + 讀取 %7.1f ms\n", text.size() / 1e6, t_tenc, text.size() / 1e3 / t_tenc, t_tdec);
+    cout << (sum_bin == sum_txt ? "結果相同" : "結果錯誤!") << endl;
+
+    // 版本演進：version 1 沒有 d，新程式讀到的是預設值 5
+    Document small;
+    small.objects.resize(1);
+    small.objects[0].d = 99;
+    vector<uint8_t> v1 = encode(small, 1), v2 = encode(small, 2);
+    uint16_t ver;
+    MCView old_m{open_buffer(v1.data(), v1.size(), &ver).get_ref_vector(DocField::objects).table_at(0)};
+    MCView new_m{open_buffer(v2.data(), v2.size()).get_ref_vector(DocField::objects).table_at(0)};
+    cout << "version " << ver << " d = " << old_m.d() << ", version 2 d = " << new_m.d() << endl;   // 5, 99
+
+    try {
+        open_buffer(v2.data(), 12);   // 不完整的 buffer
+    } catch (const bad_buffer& e) {
+        cout << "壞掉的 buffer: " << e.what() << endl;
+    }
+}
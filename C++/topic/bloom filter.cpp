@@ -0,0 +1,386 @@
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <set>
+#include <map>
+#include <unordered_map>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <stdexcept>
+
+using namespace std;
+
+//###################################
+//########### Bloom Filter ##########
+//###################################
+
+// e.count(i)、f.count(i)、g.count(i) 找不到的時候也要走完整棵紅黑樹或整條 hash chain
+// 如果大部分查詢都找不到，可以在前面放一個 filter：
+//   filter 說「沒有」就一定沒有，直接回傳 0，不碰容器
+//   filter 說「可能有」才去查容器 (有小機率誤判，叫 false positive rate, FPR)
+//
+// Blocked Bloom filter:
+//   一般 Bloom filter 的 k 個 bit 散在整個 bit 陣列，要 k 次 cache miss
+//   blocked 版本先用 hash 選一個 64 bytes (一條 cache line) 的 block，k 個 bit 都放在這個 block 裡
+//   查詢只讀一條 cache line，代價是同樣 FPR 要多用一些 bit (k 越大差越多，1e-4 時約多 15%)；不能刪除
+//
+// Cuckoo filter:
+//   存每個 key 的 fingerprint (hash 的幾個 bit)，每個 bucket 4 格，每個 key 有兩個候選 bucket
+//   i2 = hash(fp) - i1 (mod bucket 數)，只靠 fp 就能算出另一個位置，所以可以搬家(cuckoo)也可以刪除
+//   查詢最多讀兩個 bucket (兩次 cache miss)
+//   每個 key 約 (log2(1/FPR) + 3) / 0.95 bits，Bloom 約 1.44 * log2(1/FPR) (blocked 再多一些)
+//   FPR 在 0.1% 左右以下時 cuckoo 比較省；fingerprint 最多 32 bits，FPR 最低約 2e-9
+//
+// 兩者都做不到的目標 FPR 會丟 invalid_argument，不會默默給一個比較差的 filter；expected_fpr() 是模型預測的 FPR
+
+// 64-bit 整數混合 (MurmurHash3 fmix64)，只有乘法、位移、XOR，迴圈裡很容易被向量化
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33; x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33; x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+template <class K>
+inline uint64_t filter_hash(const K& k) {
+    if constexpr (is_integral<K>::value) return mix64(uint64_t(k));   // 整數不經過 std::hash (它通常就是原值)
+    else return mix64(hash<K>()(k));
+}
+
+class BlockedBloomFilter {
+public:
+    static const bool supports_erase = false;
+
+    // n: 預計 key 數量，fpr: 目標 false positive rate，最低 1e-6 (大於 0.5 就當成 0.5)
+    // (k 最多 16，再低的 FPR 需要的 bit 數會急速增加，應改用 cuckoo filter)
+    BlockedBloomFilter(size_t n, double fpr = 0.01) {
+        if (!(fpr >= 1e-6)) throw invalid_argument("BlockedBloomFilter: 目標 FPR 最低 1e-6，請改用 CuckooFilter");
+        fpr = min(0.5, fpr);
+        // 從少到多試 bits/key，每種都挑最好的 k，第一個預測 FPR 達到目標的就用它
+        double bits_per_key = 1.0;
+        for (;; bits_per_key += 0.25) {
+            double best = 1.0;
+            for (int k = 1; k <= 16; k++) {
+                double p = predicted_fpr(bits_per_key, k);
+                if (p < best) { best = p; k_ = k; }
+            }
+            if (best <= fpr) { expected_ = best; break; }
+        }
+        size_t blocks = max<size_t>(1, size_t(ceil(n * bits_per_key / 512)));
+        blocks_.assign(blocks, Block());
+    }
+
+    // blocked Bloom 的 FPR：每個 block 分到的 key 數近似 Poisson(λ = 512 / bits_per_key)
+    // 有 i 個 key 的 block 誤判率是 (1 - (1 - 1/512)^(i*k))^k，依 Poisson 機率加權平均
+    // 負載高的 block 誤判率高很多，所以比一般 Bloom 的公式 (1 - e^(-k/bits))^k 差，k 越大差越多
+    static double predicted_fpr(double bits_per_key, int k) {
+        double lambda = 512 / bits_per_key;
+        double p = exp(-lambda), sum = 0;
+        int top = int(lambda + 12 * sqrt(lambda) + 30);
+        for (int i = 0; i <= top; i++) {
+            sum += p * pow(1 - pow(1 - 1.0 / 512, double(i) * k), k);
+            p *= lambda / (i + 1);
+        }
+        return sum;
+    }
+
+    template <class K> void insert(const K& key) { insert_hash(filter_hash(key)); }
+    template <class K> bool maybe_contains(const K& key) const { return contains_hash(filter_hash(key)); }
+
+    void insert_hash(uint64_t h) {
+        Block& b = blocks_[reduce(h, blocks_.size())];
+        uint64_t seed = h, g = 0;
+        for (int i = 0; i < k_; i++) {
+            uint32_t bit = next_bit(i, seed, g);
+            b.w[bit >> 6] |= 1ULL << (bit & 63);
+        }
+    }
+
+    bool contains_hash(uint64_t h) const {
+        const Block& b = blocks_[reduce(h, blocks_.size())];
+        uint64_t seed = h, g = 0;
+        uint64_t miss = 0;   // 不提早 return，k 個 bit 一起檢查，沒有分支
+        for (int i = 0; i < k_; i++) {
+            uint32_t bit = next_bit(i, seed, g);
+            miss |= ~b.w[bit >> 6] & (1ULL << (bit & 63));
+        }
+        return miss == 0;
+    }
+
+    // 一次查一批：先把所有 hash 算完 (可向量化)，再逐個查 block
+    template <class K>
+    void maybe_contains_batch(const K* keys, size_t n, bool* out) const {
+        vector<uint64_t> h(n);
+        for (size_t i = 0; i < n; i++) h[i] = filter_hash(keys[i]);
+        for (size_t i = 0; i < n; i++) out[i] = contains_hash(h[i]);
+    }
+
+    size_t bytes() const { return blocks_.size() * sizeof(Block); }
+    int hashes() const { return k_; }
+    double expected_fpr() const { return expected_; }   // 放滿 n 個 key 時 predicted_fpr 的值
+
+private:
+    struct alignas(64) Block { uint64_t w[8] = {0}; };   // 512 bits = 一條 cache line
+    vector<Block> blocks_;
+    int k_;
+    double expected_;
+
+    // 用 hash 的高 32 bit 選 block：對應到 [0, n)，用乘法取高位代替 %
+    static size_t reduce(uint64_t h, size_t n) { return size_t((h >> 32) * n >> 32); }
+    // block 內第 i 個 bit 的位置：每個位置取 9 bits，一個 64-bit 用完 (7 個) 就再混一次拿新的
+    // 不用 h1 + i*h2 的 double hashing：那樣 block 內只有約 2^17 種 bit 組合，FPR 降不到 1e-3 以下
+    static uint32_t next_bit(int i, uint64_t& seed, uint64_t& g) {
+        if (i % 7 == 0) g = seed = mix64(seed + 0x9E3779B97F4A7C15ULL);
+        uint32_t bit = uint32_t(g & 511);
+        g >>= 9;
+        return bit;
+    }
+};
+
+class CuckooFilter {
+public:
+    static const bool supports_erase = true;
+    static const int SLOTS = 4;   // 每個 bucket 4 格
+
+    // fingerprint 長度 f 由 fpr 決定：FPR 約為 2*SLOTS / 2^f (f 最多 32，所以 FPR 最低約 1.9e-9，再低就丟例外)
+    // 每格只用 f 個 bit，緊密排在 bits_ 裡；bucket 數不必是 2 的次方，bytes/key 不會隨 n 跳動
+    CuckooFilter(size_t n, double fpr = 0.01) : size_(0) {
+        if (!(fpr > 0)) throw invalid_argument("CuckooFilter: 目標 FPR 要大於 0");
+        int f = (int)ceil(log2(2.0 * SLOTS / fpr));
+        if (f > 32) throw invalid_argument("CuckooFilter: 目標 FPR 太低，fingerprint 最多 32 bits (FPR 約 1.9e-9)");
+        fp_bits_ = max(4, f);
+        fp_mask_ = uint32_t((uint64_t(1) << fp_bits_) - 1);   // f = 32 時 1u << 32 是未定義行為，所以用 64-bit 算
+        buckets_ = max<size_t>(1, size_t(ceil(n / (SLOTS * 0.95))));   // 4 格的 cuckoo 最多約 95% 滿
+        bits_.assign((buckets_ * SLOTS * fp_bits_ + 63) / 64 + 1, 0);  // 多一個 word，跨 word 讀取不會越界
+    }
+
+    template <class K> bool insert(const K& key) {
+        uint64_t h = filter_hash(key);
+        uint32_t fp = fingerprint(h);
+        size_t i1 = index(h), i2 = alt(i1, fp);
+        if (put(i1, fp) || put(i2, fp)) { size_++; return true; }
+        size_t i = (h & 1) ? i1 : i2;   // 兩個都滿了，隨機踢掉一個，讓它去它的另一個 bucket
+        for (int kick = 0; kick < 500; kick++) {
+            size_t slot = i * SLOTS + ((h >> (2 * (kick % 16))) & (SLOTS - 1));
+            uint32_t old = get(slot);
+            set(slot, fp);
+            fp = old;
+            i = alt(i, fp);
+            if (put(i, fp)) { size_++; return true; }
+        }
+        // 太滿了：被踢出來的 fp 放不回去，存在 victim 裡，查詢時也要看它
+        victim_.push_back({i, fp});
+        size_++;
+        return false;
+    }
+
+    template <class K> bool maybe_contains(const K& key) const {
+        uint64_t h = filter_hash(key);
+        uint32_t fp = fingerprint(h);
+        size_t i1 = index(h), i2 = alt(i1, fp);
+        if (has(i1, fp) || has(i2, fp)) return true;
+        for (auto& v : victim_) if (v.second == fp && (v.first == i1 || v.first == i2)) return true;
+        return false;
+    }
+
+    // 只能刪除確定有 insert 過的 key，否則可能刪到別人的 fingerprint
+    template <class K> bool erase(const K& key) {
+        uint64_t h = filter_hash(key);
+        uint32_t fp = fingerprint(h);
+        size_t i1 = index(h), i2 = alt(i1, fp);
+        for (size_t i : {i1, i2})
+            for (int s = 0; s < SLOTS; s++)
+                if (get(i * SLOTS + s) == fp) { set(i * SLOTS + s, 0); size_--; return true; }
+        for (auto it = victim_.begin(); it != victim_.end(); ++it)
+            if (it->second == fp && (it->first == i1 || it->first == i2)) { victim_.erase(it); size_--; return true; }
+        return false;
+    }
+
+    size_t bytes() const { return bits_.size() * sizeof(uint64_t) + victim_.size() * sizeof(victim_[0]); }
+    size_t size() const { return size_; }
+    int fingerprint_bits() const { return fp_bits_; }
+    double expected_fpr() const { return 2.0 * SLOTS / (double(fp_mask_) + 1); }   // 每個 bucket 都放滿時的上限
+
+private:
+    vector<uint64_t> bits_;   // 第 s 格在 bits_ 的第 s*fp_bits_ 個 bit 開始，0 代表空格
+    vector<pair<size_t, uint32_t>> victim_;
+    size_t buckets_, size_;
+    int fp_bits_;
+    uint32_t fp_mask_;
+
+    // 低 32 bit 拿去選 bucket，fingerprint 用高 32 bit，兩者互相獨立
+    uint32_t fingerprint(uint64_t h) const {
+        uint32_t fp = uint32_t(h >> 32) & fp_mask_;
+        return fp ? fp : 1;   // 0 保留給空格
+    }
+    size_t index(uint64_t h) const { return size_t((h & 0xFFFFFFFF) * buckets_ >> 32); }   // 對應到 [0, buckets_)
+    // 另一個 bucket：(H(fp) - i) mod m，再做一次會回到 i，bucket 數不用是 2 的次方 (XOR 的版本才需要)
+    size_t alt(size_t i, uint32_t fp) const {
+        size_t hf = size_t(mix64(fp) % buckets_);
+        return hf >= i ? hf - i : hf + buckets_ - i;
+    }
+
+    // 讀寫第 s 格：fp_bits_ <= 32，最多跨兩個 word
+    uint32_t get(size_t s) const {
+        size_t o = s * fp_bits_, w = o >> 6;
+        unsigned sh = o & 63;
+        uint64_t v = bits_[w] >> sh;
+        if (sh + fp_bits_ > 64) v |= bits_[w + 1] << (64 - sh);
+        return uint32_t(v & fp_mask_);
+    }
+    void set(size_t s, uint32_t fp) {
+        size_t o = s * fp_bits_, w = o >> 6;
+        unsigned sh = o & 63;
+        bits_[w] = (bits_[w] & ~(uint64_t(fp_mask_) << sh)) | (uint64_t(fp) << sh);
+        if (sh + fp_bits_ > 64) {
+            unsigned lo = 64 - sh;   // 前面 word 放了 lo 個 bit，剩下的放下一個 word
+            bits_[w + 1] = (bits_[w + 1] & ~(uint64_t(fp_mask_) >> lo)) | (uint64_t(fp) >> lo);
+        }
+    }
+    bool put(size_t i, uint32_t fp) {
+        for (int s = 0; s < SLOTS; s++)
+            if (!get(i * SLOTS + s)) { set(i * SLOTS + s, fp); return true; }
+        return false;
+    }
+    bool has(size_t i, uint32_t fp) const {
+        size_t s = i * SLOTS;
+        return (get(s) == fp) | (get(s + 1) == fp) | (get(s + 2) == fp) | (get(s + 3) == fp);
+    }
+};
+
+//###################################
+//############ Prefilter ############
+//###################################
+
+// 包在 set / map / unordered_map 外面，count/find 先問 filter
+// 容器的修改要經過 wrapper，filter 才會同步
+template <class K> const K& key_of(const K& k) { return k; }                      // set 的元素就是 key
+template <class K, class V> const K& key_of(const pair<const K, V>& p) { return p.first; }   // map 取 first
+
+template <class Container, class Filter>
+class Prefiltered {
+public:
+    typedef typename Container::key_type key_type;
+    typedef typename Container::value_type value_type;
+    typedef typename Container::iterator iterator;
+
+    // 依照容器現有的 key 建立 filter
+    Prefiltered(Container& c, Filter f) : c_(c), f_(std::move(f)) {
+        for (auto& v : c_) f_.insert(key_of(v));
+    }
+
+    size_t count(const key_type& k) const { return f_.maybe_contains(k) ? c_.count(k) : 0; }
+    iterator find(const key_type& k) { return f_.maybe_contains(k) ? c_.find(k) : c_.end(); }
+    iterator end() { return c_.end(); }
+
+    pair<iterator, bool> insert(const value_type& v) {
+        auto r = c_.insert(v);
+        if (r.second) f_.insert(key_of(v));
+        return r;
+    }
+
+    // Bloom filter 刪不掉，key 留在 filter 裡只會多一個 false positive，結果仍然正確
+    size_t erase(const key_type& k) {
+        size_t n = c_.erase(k);
+        if (n && Filter::supports_erase) erase_from_filter(f_, k);
+        return n;
+    }
+
+    const Filter& filter() const { return f_; }
+    Container& container() { return c_; }
+
+private:
+    Container& c_;
+    Filter f_;
+
+    template <class F> static auto erase_from_filter(F& f, const key_type& k) -> decltype(f.erase(k), void()) { f.erase(k); }
+    static void erase_from_filter(...) {}
+};
+
+template <class Container, class Filter>
+Prefiltered<Container, Filter> prefilter(Container& c, Filter f) { return Prefiltered<Container, Filter>(c, std::move(f)); }
+
+//###################################
+//############ Benchmark ############
+//###################################
+
+template <class F>
+double time_ms(F fn) {
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+// 量測實際 FPR：用一定不在裡面的 key 去問
+template <class Filter>
+double measured_fpr(const Filter& f, const vector<int>& absent) {
+    size_t fp = 0;
+    for (int k : absent) fp += f.maybe_contains(k);
+    return double(fp) / absent.size();
+}
+
+template <class Container, class Filter>
+void bench(const char* name, Container& c, Filter f, const vector<int>& probes, const vector<int>& absent) {
+    auto pf = prefilter(c, std::move(f));
+    size_t h1 = 0, h2 = 0;
+    double t_raw = time_ms([&]{ for (int k : probes) h1 += c.count(k); });
+    double t_pf = time_ms([&]{ for (int k : probes) h2 += pf.count(k); });
+    printf("%-34s %7.1f ms -> %7.1f ms  FPR %.4f  %5.2f bytes/key  %s\n", name, t_raw, t_pf,
+           measured_fpr(pf.filter(), absent), double(pf.filter().bytes()) / c.size(), h1 == h2 ? "結果相同" : "結果錯誤!");
+}
+
+int main(int argc, char** argv) {
+    // 用法：./bloom [N] [fpr]
+    size_t N = argc > 1 ? stoull(argv[1]) : 1000000;
+    double fpr = argc > 2 ? stod(argv[2]) : 0.01;
+
+    // 偶數放進容器，奇數一定不在裡面；查詢 95% 找不到
+    mt19937 rng(42);
+    vector<int> keys(N), probes(2000000), absent(4000000);
+    for (size_t i = 0; i < N; i++) keys[i] = int(rng() & 0x7FFFFFFE);
+    for (auto& p : probes) p = (rng() % 20 == 0) ? keys[rng() % N] : int(rng() | 1) & 0x7FFFFFFF;
+    for (auto& a : absent) a = int(rng() | 1) & 0x7FFFFFFF;
+
+    set<int> e(keys.begin(), keys.end());
+    map<int, string> f;
+    unordered_map<int, int> g;
+    for (int k : keys) { f[k] = "value"; g[k] = k; }
+
+    printf("N = %zu, 目標 FPR %.4f, 查詢 %zu 次 (95%% 找不到)\n", N, fpr, probes.size());
+    bench("set + BlockedBloom", e, BlockedBloomFilter(N, fpr), probes, absent);
+    bench("set + Cuckoo", e, CuckooFilter(N, fpr), probes, absent);
+    bench("map<int,string> + BlockedBloom", f, BlockedBloomFilter(N, fpr), probes, absent);
+    bench("map<int,string> + Cuckoo", f, CuckooFilter(N, fpr), probes, absent);
+    bench("unordered_map + BlockedBloom", g, BlockedBloomFilter(N, fpr), probes, absent);
+    bench("unordered_map + Cuckoo", g, CuckooFilter(N, fpr), probes, absent);
+
+    // 不同的目標 FPR：實際量到的 FPR 應該在目標附近或更低
+    // (absent 只有 4M 個，低於 1e-6 的 FPR 量不太出來，看預測值就好)
+    printf("\n目標 FPR     BlockedBloom 實測/預測 (k, bytes/key)     Cuckoo 實測/預測 (f, bytes/key)\n");
+    for (double target : {1e-2, 1e-3, 1e-4, 1e-5, 1e-6}) {
+        BlockedBloomFilter bb(e.size(), target);
+        CuckooFilter cf(e.size(), target);
+        for (int k : e) { bb.insert(k); cf.insert(k); }
+        printf("%-10g   %.2e / %.2e (%2d, %5.2f)       %.2e / %.2e (%2d, %5.2f)\n", target,
+               measured_fpr(bb, absent), bb.expected_fpr(), bb.hashes(), double(bb.bytes()) / e.size(),
+               measured_fpr(cf, absent), cf.expected_fpr(), cf.fingerprint_bits(), double(cf.bytes()) / e.size());
+    }
+    try {
+        BlockedBloomFilter too_low(N, 1e-9);
+    } catch (invalid_argument& ex) {
+        printf("BlockedBloomFilter(N, 1e-9): %s\n", ex.what());
+    }
+    CuckooFilter low(e.size(), 1e-8);
+    printf("CuckooFilter(N, 1e-8): f = %d, 預測 FPR %.2e\n", low.fingerprint_bits(), low.expected_fpr());
+
+    // 刪除：cuckoo 會同步把 fingerprint 刪掉
+    auto pc = prefilter(e, CuckooFilter(N, fpr));
+    int k = *e.begin();
+    pc.erase(k);
+    cout << "erase 後 count = " << pc.count(k) << ", filter 內 " << pc.filter().size() << " 個" << endl;
+}
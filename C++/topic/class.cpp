@@ -1,15 +1,19 @@
 #include <iostream>
+#include "trace.h"   //編譯時加 -DTRACE 可記錄各段花費的時間 (見 trace.h)
+#include "handle.h"  //Unique、CowBuffer，編譯時加 -DHANDLE_AUDIT 可統計複製/搬移次數 (見 handle.h)
 using namespace std;
 
 // Class
-class MyClass{ //class預設為private; struct預設為public;
+class MyClass : public handle::Counted<MyClass>{ //class預設為private; struct預設為public;
 private:   //class內部才可呼叫(可呼叫public使用private的參數)
 public:    //class外部可以呼叫
     int a;
-    int* b;
-    MyClass():a(0),b(0),c(10){};    // constructor initializer list
-    MyClass(int a):a(a),b(0){};
-    MyClass(int a, int* b):a(a),b(b){};
+    handle::CowBuffer<int> b;   //原本是 int* b：不知道誰要 delete，複製 MyClass 時兩個物件還會指向同一塊
+                                //CowBuffer 自己管理記憶體，複製時共用，要修改時 (b.set) 才真的複製一份
+    MyClass():a(0),c(10){};     // constructor initializer list
+    MyClass(int a):a(a){};
+    MyClass(int a, handle::CowBuffer<int> b):a(a),b(std::move(b)){};   //std::move：把 b 搬進來，不多複製一次
+    //沒有自己寫 copy/move constructor 和 destructor：成員都會自己管理，compiler 產生的就是對的 (rule of zero)
     void print();     //宣告函數
 protected: int c;     //繼承的class和內部才能呼叫
     friend class ReName;  //可和NewName這個class共享private參數
@@ -25,7 +29,7 @@ class MC : public MyClass{
 public:
     using MyClass :: MyClass;   //直接使用MyClass的建構式
     MC():MyClass(), d(5){a=5;}  //使用MC本身的建構式，將MyClass初始化
-    //並可取得 a=5, b=0, c=10, d=5
+    //並可取得 a=5, b 為空, c=10, d=5
     void Multiply(){cout << a*c*d << endl;}
     // using MyClass :: c; //將c維持在public
 protected:
@@ -65,6 +69,7 @@ class base_A {
 public:
     // Pure Virtual Function: 只宣告 virtual function 不寫內容
     virtual void f() = 0;
+    virtual ~base_A() = default;   // 用 base_A* 刪除 derived_A 時，要有 virtual destructor 才會呼叫到 derived_A 的
     // 若使用 Pure Virtual Function 的類為 Abstract Class
     // 無法由外部產生類實例，即 base_A MyClass; 寫法會報錯
 };
@@ -86,24 +91,30 @@ int main() {
     MyClass t;  //t 是MyClass資料型別的class
     // MyClass t(1);
     
-    // MyClass* f;
-    MyClass* f = new MyClass(); //f 是指向MyClass資料型別的pointer
-    // MyClass* f = new MyClass(2);
+    // MyClass* f = new MyClass();  //f 是指向MyClass資料型別的pointer，new 出來的要自己 delete
+    handle::Unique<MyClass> f = handle::make_unique<MyClass>(); //f 擁有這個物件，離開 scope 時自動 delete
+    // handle::Unique<MyClass> f = handle::make_unique<MyClass>(2);
     
-    t.print();
-    f->print();
-    cout << t.a << endl;         //class  用  . 獲取public的參數或函式
-    cout << f->a << endl;        //pointer用 -> 獲取public的參數或函式
+    {
+        TRACE_SCOPE("Class 呼叫");
+        t.print();
+        f->print();
+        cout << t.a << endl;         //class  用  . 獲取public的參數或函式
+        cout << f->a << endl;        //pointer用 -> 獲取public的參數或函式
+    }
     
-    delete f; //new的方法記得釋放記憶體
-    f=0;
+    // delete f; f=0;  //用 raw pointer 時記得釋放記憶體，中途 return 或 throw 就會 leak
+    f.reset();           //Unique 可以提早釋放，不寫也會在離開 scope 時釋放
     
     // Class 的繼承
-    MC g;
-    g.Multiply();          //250
-    g.print();             //Hello World 註：若父子有同名函式，會優先使用自己的
-    cout << g.a << endl;   //5
-    MC r(3);               //a=3,b=0 直接使用MyClass的建構式
+    {
+        TRACE_SCOPE("Class 繼承");
+        MC g;
+        g.Multiply();          //250
+        g.print();             //Hello World 註：若父子有同名函式，會優先使用自己的
+        cout << g.a << endl;   //5
+        MC r(3);               //a=3,b 為空 直接使用MyClass的建構式
+    }
     
     // Virtual function
     base* p;       // base 可指向 derived，若在 base 使用 virtual function
@@ -111,13 +122,21 @@ int main() {
     p = &obj1;     // 好處是能用 base 這個共同的介面去操作其他的 derived
     // 也可寫為 base* p = new derived();
     // 此時的 derived 裡同名的函數也被自動設定為 virtual function
-    p->fun_1();    // base-1   ，非virtual function，用 base 的
-    p->fun_2();    // derived-2，virtual function，用 derived 的
-    p->fun_3();    // base-3   ，derived 無同名函數
-    p->fun_4();    // base-4   ，base 和 derived 的 fun_4 不算同名
+    {
+        TRACE_SCOPE("Virtual function");
+        p->fun_1();    // base-1   ，非virtual function，用 base 的
+        p->fun_2();    // derived-2，virtual function，用 derived 的
+        p->fun_3();    // base-3   ，derived 無同名函數
+        p->fun_4();    // base-4   ，base 和 derived 的 fun_4 不算同名
+    }
     
     // Abstract Class
-    base_A* a = new derived_A();
-    a->f();        // derived_A
+    // base_A* a = new derived_A();   //沒有 delete a 就會 leak
+    handle::Unique<base_A> a = handle::make_unique<derived_A>();
+    {
+        TRACE_SCOPE("Abstract Class");
+        a->f();        // derived_A
+    }
     
+    TRACE_DUMP("trace.json");
 }
\ No newline at end of file
@@ -0,0 +1,334 @@
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <set>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <cstring>
+#ifdef __SSSE3__
+#include <tmmintrin.h>   // _mm_shuffle_epi8 (編譯時加 -mssse3 或 -march=native 才會啟用)
+#endif
+
+using namespace std;
+
+//###################################
+//########## Compressed Set #########
+//###################################
+
+// set<int> e 是紅黑樹，每個 node 除了 4 bytes 的值還有左右子、父節點 pointer 和顏色，大約 40 bytes
+// 排好序、不重複的 ID 串列可以只存「相鄰兩數的差」(delta)，差值通常很小，用很少的 bit 就存得下
+//
+// 每 128 個數切成一個 block，另外存一份 skip index (每個 block 的第一個值、最後一個值、資料位置)
+// count/find 先對 skip index 做 binary search 找到 block，只解壓那一個 block
+//
+// block 內的 delta 有三種編碼：
+//   PFOR:        挑一個 bit 寬度 b，所有 delta 都用 b 個 bit 緊密排列 (bit-packing)
+//                少數放不下的大 delta 當作例外 (exception)，高位另外存，這樣 b 不會被極端值拉大
+//   Varint:      每個 byte 用 7 bit 存資料，最高位表示後面還有沒有 byte (LEB128)，小的數只要 1 byte
+//   StreamVByte: 每個數用 1~4 bytes，長度集中存在 control byte (每個數 2 bit)
+//                4 個數一組，查表得到 shuffle mask 後用一個 SIMD 指令就能解出 4 個數
+
+enum Encoding { PFOR, VARINT, STREAMVBYTE };
+
+class CompressedSet {
+public:
+    static const int BLOCK = 128;
+    static const size_t npos = size_t(-1);
+
+    // 和 set<int> e(arr, arr+n) 一樣：會排序並去掉重複的值
+    CompressedSet(vector<uint32_t> values, Encoding enc = PFOR) : enc_(enc) {
+        sort(values.begin(), values.end());
+        values.erase(unique(values.begin(), values.end()), values.end());
+        size_ = values.size();
+
+        uint32_t delta[BLOCK];
+        for (size_t b = 0; b < size_; b += BLOCK) {
+            int n = (int)min<size_t>(BLOCK, size_ - b);
+            first_.push_back(values[b]);
+            last_.push_back(values[b + n - 1]);
+            offset_.push_back((uint32_t)data_.size());
+            delta[0] = 0;
+            for (int i = 1; i < n; i++) delta[i] = values[b + i] - values[b + i - 1];
+            switch (enc_) {
+                case PFOR:        encode_pfor(delta, n); break;
+                case VARINT:      encode_varint(delta, n); break;
+                case STREAMVBYTE: encode_svb(delta, n); break;
+            }
+        }
+        data_.resize(data_.size() + 16, 0);  // 解碼時會一次讀 8 或 16 bytes，尾端補 0 避免讀出界
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t blocks() const { return first_.size(); }
+
+    // 實際佔用的記憶體 (資料 + skip index)
+    size_t bytes() const {
+        return data_.size() + (first_.size() + last_.size() + offset_.size()) * sizeof(uint32_t);
+    }
+
+    // 解出第 blk 個 block，回傳元素個數 (out 至少要有 BLOCK 個空間)
+    int decode_block(size_t blk, uint32_t* out) const {
+        int n = (int)min<size_t>(BLOCK, size_ - blk * BLOCK);
+        const uint8_t* p = data_.data() + offset_[blk];
+        switch (enc_) {
+            case PFOR:        decode_pfor(p, n, first_[blk], out); break;
+            case VARINT:      decode_varint(p, n, first_[blk], out); break;
+            case STREAMVBYTE: decode_svb(p, n, first_[blk], out); break;
+        }
+        return n;
+    }
+
+    void decode_all(vector<uint32_t>& out) const {
+        out.resize(size_ + BLOCK);   // 多留一個 block 的空間，每個 block 可以直接解到 out 裡
+        for (size_t b = 0; b < blocks(); b++) decode_block(b, &out[b * BLOCK]);
+        out.resize(size_);
+    }
+
+    // 回傳 x 在排序後的位置，沒有則回傳 npos (對應 e.find(x))
+    size_t find(uint32_t x) const {
+        // 找最後一個 first_ <= x 的 block
+        size_t blk = upper_bound(first_.begin(), first_.end(), x) - first_.begin();
+        if (blk == 0) return npos;
+        blk--;
+        if (x > last_[blk]) return npos;   // 落在兩個 block 中間，連解壓都不用
+        uint32_t buf[BLOCK];
+        int n = decode_block(blk, buf);
+        const uint32_t* it = lower_bound(buf, buf + n, x);
+        return (it != buf + n && *it == x) ? blk * BLOCK + (it - buf) : npos;
+    }
+
+    size_t count(uint32_t x) const { return find(x) != npos ? 1 : 0; }   // 和 set 一樣只會是 0,1
+
+    // 交集：依 skip index 跳過值域不重疊的 block，只解壓有可能重疊的 block
+    friend vector<uint32_t> intersect(const CompressedSet& a, const CompressedSet& b) {
+        vector<uint32_t> out;
+        uint32_t bufA[BLOCK], bufB[BLOCK];
+        size_t ia = 0, ib = 0, decA = npos, decB = npos;
+        int na = 0, nb = 0;
+        while (ia < a.blocks() && ib < b.blocks()) {
+            if (a.last_[ia] < b.first_[ib]) { ia++; continue; }
+            if (b.last_[ib] < a.first_[ia]) { ib++; continue; }
+            if (decA != ia) { na = a.decode_block(ia, bufA); decA = ia; }
+            if (decB != ib) { nb = b.decode_block(ib, bufB); decB = ib; }
+            set_intersection(bufA, bufA + na, bufB, bufB + nb, back_inserter(out));
+            uint32_t la = a.last_[ia], lb = b.last_[ib];
+            if (la <= lb) ia++;
+            if (lb <= la) ib++;
+        }
+        return out;
+    }
+
+    // 聯集：兩邊都要走完，逐 block 解壓後合併
+    friend vector<uint32_t> unite(const CompressedSet& a, const CompressedSet& b) {
+        vector<uint32_t> out, va, vb;
+        out.reserve(a.size() + b.size());
+        a.decode_all(va);
+        b.decode_all(vb);
+        set_union(va.begin(), va.end(), vb.begin(), vb.end(), back_inserter(out));
+        return out;
+    }
+
+private:
+    Encoding enc_;
+    size_t size_;
+    vector<uint32_t> first_;    // skip index：每個 block 的第一個值
+    vector<uint32_t> last_;     // skip index：每個 block 的最後一個值
+    vector<uint32_t> offset_;   // skip index：每個 block 在 data_ 裡的起點
+    vector<uint8_t> data_;
+
+    static int bits(uint32_t x) { return x ? 32 - __builtin_clz(x) : 0; }
+
+    void put_varint(uint32_t x) {
+        while (x >= 0x80) { data_.push_back(uint8_t(x | 0x80)); x >>= 7; }
+        data_.push_back(uint8_t(x));
+    }
+    static uint32_t get_varint(const uint8_t*& p) {
+        uint32_t x = 0;
+        for (int s = 0; ; s += 7) {
+            uint8_t c = *p++;
+            x |= uint32_t(c & 0x7F) << s;
+            if (!(c & 0x80)) return x;
+        }
+    }
+
+    //---------------- PFOR ----------------
+    // [b][例外個數][n 個 b-bit 的值][例外: (位置, 高位 varint) ...]
+    void encode_pfor(const uint32_t* d, int n) {
+        int cnt[33] = {0};   // cnt[k]: 需要剛好 k 個 bit 的 delta 個數
+        for (int i = 0; i < n; i++) cnt[bits(d[i])]++;
+        int best_b = 32; size_t best_cost = size_t(-1);
+        int exc = 0;                                   // 需要超過 b 個 bit 的個數
+        for (int b = 32; b >= 0; b--) {
+            size_t cost = (size_t(n) * b + 7) / 8 + size_t(exc) * 4;   // 例外大約 4 bytes
+            if (cost <= best_cost) { best_cost = cost; best_b = b; }
+            exc += cnt[b];
+        }
+        int b = best_b;
+        vector<int> exceptions;
+        for (int i = 0; i < n; i++) if (bits(d[i]) > b) exceptions.push_back(i);
+
+        data_.push_back(uint8_t(b));
+        data_.push_back(uint8_t(exceptions.size()));
+        uint64_t acc = 0; int filled = 0;
+        uint64_t mask = b == 32 ? 0xFFFFFFFFull : ((1ull << b) - 1);
+        for (int i = 0; i < n; i++) {
+            acc |= (d[i] & mask) << filled;
+            filled += b;
+            while (filled >= 8) { data_.push_back(uint8_t(acc)); acc >>= 8; filled -= 8; }
+        }
+        if (filled > 0) data_.push_back(uint8_t(acc));
+        for (int i : exceptions) {
+            data_.push_back(uint8_t(i));
+            put_varint(uint32_t(uint64_t(d[i]) >> b));
+        }
+    }
+
+    static void decode_pfor(const uint8_t* p, int n, uint32_t first, uint32_t* out) {
+        int b = p[0], exc = p[1];
+        p += 2;
+        uint64_t mask = b == 32 ? 0xFFFFFFFFull : ((1ull << b) - 1);
+        for (int i = 0; i < n; i++) {      // 一次讀 8 bytes，位移後取出 b 個 bit (b<=32，最多用到 39 bit)
+            size_t bit = size_t(i) * b;
+            uint64_t w;
+            memcpy(&w, p + bit / 8, 8);
+            out[i] = uint32_t((w >> (bit % 8)) & mask);
+        }
+        p += (size_t(n) * b + 7) / 8;
+        for (int e = 0; e < exc; e++) {
+            int pos = *p++;
+            out[pos] |= get_varint(p) << b;
+        }
+        uint32_t v = first;                // delta 轉回原本的值 (prefix sum)
+        for (int i = 0; i < n; i++) { v += out[i]; out[i] = v; }
+    }
+
+    //---------------- Varint ----------------
+    void encode_varint(const uint32_t* d, int n) {
+        for (int i = 0; i < n; i++) put_varint(d[i]);
+    }
+
+    static void decode_varint(const uint8_t* p, int n, uint32_t first, uint32_t* out) {
+        uint32_t v = first;
+        for (int i = 0; i < n; i++) { v += get_varint(p); out[i] = v; }
+    }
+
+    //---------------- StreamVByte ----------------
+    // [control bytes: (n+3)/4 個][資料 bytes]
+    void encode_svb(const uint32_t* d, int n) {
+        size_t ctrl = data_.size();
+        data_.resize(ctrl + (n + 3) / 4, 0);
+        for (int i = 0; i < n; i++) {
+            int len = max(1, (bits(d[i]) + 7) / 8);
+            data_[ctrl + i / 4] |= uint8_t((len - 1) << (2 * (i % 4)));
+            for (int k = 0; k < len; k++) data_.push_back(uint8_t(d[i] >> (8 * k)));
+        }
+    }
+
+    struct SvbTable {   // control byte -> 4 個數的總長度和 shuffle mask
+        uint8_t len[256];
+        uint8_t shuf[256][16];
+        SvbTable() {
+            for (int c = 0; c < 256; c++) {
+                int pos = 0;
+                for (int k = 0; k < 4; k++) {
+                    int l = ((c >> (2 * k)) & 3) + 1;
+                    for (int j = 0; j < 4; j++) shuf[c][4 * k + j] = j < l ? uint8_t(pos + j) : 0x80;  // 0x80 填 0
+                    pos += l;
+                }
+                len[c] = uint8_t(pos);
+            }
+        }
+    };
+
+    static void decode_svb(const uint8_t* p, int n, uint32_t first, uint32_t* out) {
+        static const SvbTable T;
+        const uint8_t* ctrl = p;
+        const uint8_t* data = p + (n + 3) / 4;
+        int i = 0;
+        uint32_t v = first;
+#ifdef __SSSE3__
+        __m128i prev = _mm_set1_epi32((int)first);
+        for (; i + 4 <= n; i += 4) {
+            uint8_t c = ctrl[i / 4];
+            __m128i x = _mm_loadu_si128((const __m128i*)data);
+            x = _mm_shuffle_epi8(x, _mm_loadu_si128((const __m128i*)T.shuf[c]));
+            x = _mm_add_epi32(x, _mm_slli_si128(x, 4));   // 4 個 delta 的 prefix sum
+            x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+            x = _mm_add_epi32(x, prev);
+            _mm_storeu_si128((__m128i*)(out + i), x);
+            prev = _mm_shuffle_epi32(x, 0xFF);             // 最後一個值廣播給下一組
+            data += T.len[c];
+        }
+        if (i > 0) v = out[i - 1];
+#endif
+        for (; i < n; i++) {
+            int len = ((ctrl[i / 4] >> (2 * (i % 4))) & 3) + 1;
+            uint32_t d = 0;
+            for (int k = 0; k < len; k++) d |= uint32_t(data[k]) << (8 * k);
+            data += len;
+            v += d;
+            out[i] = v;
+        }
+    }
+};
+
+//###################################
+//############ Benchmark ############
+//###################################
+
+template <class F>
+double time_ms(F fn) {
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    // 用法：./compressed [N] [平均間距]
+    size_t N = argc > 1 ? stoull(argv[1]) : 2000000;
+    uint32_t gap = argc > 2 ? stoul(argv[2]) : 16;
+
+    mt19937 rng(42);
+    vector<uint32_t> ids(N), ids2(N);
+    uniform_int_distribution<uint32_t> step(1, 2 * gap - 1);   // 平均間距為 gap，偶爾也放大間距測試 PFOR 例外
+    uint32_t v = 0, w = 0;
+    for (size_t i = 0; i < N; i++) {
+        v += step(rng) + (rng() % 1000 == 0 ? 100000 : 0);
+        w += step(rng);
+        ids[i] = v; ids2[i] = w;
+    }
+
+    set<uint32_t> e(ids.begin(), ids.end());
+    vector<uint32_t> probes(1000000);
+    for (auto& p : probes) p = rng() % (v + 1);
+
+    size_t hit_set = 0;
+    double t_set = time_ms([&]{ for (auto p : probes) hit_set += e.count(p); });
+    printf("N = %zu, 平均間距 %u\n", N, gap);
+    printf("set<uint32_t>   %9.1f MB (約 40 bytes/node)  count %6.1f ms\n", N * 40 / 1e6, t_set);
+    printf("vector<uint32_t>%9.1f MB\n", N * 4 / 1e6);
+
+    const char* names[] = {"PFOR", "Varint", "StreamVByte"};
+    for (Encoding enc : {PFOR, VARINT, STREAMVBYTE}) {
+        CompressedSet cs(ids, enc);
+        vector<uint32_t> out;
+        int reps = 10;
+        double t_dec = time_ms([&]{ for (int r = 0; r < reps; r++) cs.decode_all(out); });
+        size_t hit = 0;
+        double t_cnt = time_ms([&]{ for (auto p : probes) hit += cs.count(p); });
+        printf("%-15s %9.1f MB (%4.1fx)  count %6.1f ms  decode %5.2f GB/s  %s\n",
+               names[enc], cs.bytes() / 1e6, N * 4.0 / cs.bytes(), t_cnt,
+               N * 4.0 * reps / (t_dec * 1e6), (out == ids && hit == hit_set) ? "結果相同" : "結果錯誤!");
+    }
+
+    CompressedSet a(ids), b(ids2);
+    vector<uint32_t> inter, uni, ref_inter, ref_uni;
+    double t_i = time_ms([&]{ inter = intersect(a, b); });
+    double t_u = time_ms([&]{ uni = unite(a, b); });
+    set_intersection(ids.begin(), ids.end(), ids2.begin(), ids2.end(), back_inserter(ref_inter));
+    set_union(ids.begin(), ids.end(), ids2.begin(), ids2.end(), back_inserter(ref_uni));
+    printf("intersect %6.1f ms (%zu 個)  union %6.1f ms (%zu 個)  %s\n", t_i, inter.size(), t_u, uni.size(),
+           (inter == ref_inter && uni == ref_uni) ? "結果相同" : "結果錯誤!");
+}
@@ -0,0 +1,257 @@
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <limits>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <stdexcept>
+
+using namespace std;
+
+//###################################
+//####### Expression Template #######
+//###################################
+
+// advance.cpp 的 #define SUM(a,b) (a+b)、MIN(A,B) 是文字替換，沒有型態檢查，參數還可能被算兩次
+// 換成 inline 函式就安全了，但對整個 vector 運算時又有另一個問題：
+//
+//   vector<double> r = a + b * c;   (假設有寫 operator)
+//   b * c 先產生一個暫時的 vector，再和 a 相加又產生一個，每個中間結果都要配置記憶體、整個走一遍
+//
+// Expression template 讓 operator 不馬上計算，而是回傳一個「描述運算的小物件」
+//   a + b * c 的型態是 Binary<AddOp, Array, Binary<MulOp, Array, Array>>，陣列只存參照
+// 等到 r = ... 賦值時才用一個迴圈計算 r[i] = a[i] + b[i] * c[i]
+// 沒有暫存 vector，而且整個運算式 inline 展開後就是簡單的迴圈，-O2/-O3 會自動向量化 (SIMD)
+
+// 所有運算式的共同基底 (CRTP)：E 是實際的型態，用來限制 operator 只對運算式生效
+// 每個運算式型態有 static bool broadcast：整個運算式只由純量組成時為 true，長度由另一邊決定
+// 不能用 size() == 0 判斷，否則空的 Array 和長度 10 的 Array 相加會被當成純量而讀超出範圍
+template <class E>
+struct Expr {
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+template <class T>
+class Array : public Expr<Array<T>> {
+public:
+    typedef T value_type;
+    static const bool broadcast = false;
+
+    Array() {}
+    explicit Array(size_t n, T v = T()) : data_(n, v) {}
+    Array(initializer_list<T> il) : data_(il) {}
+
+    // 從運算式建立/賦值：只有這裡會真正跑迴圈
+    template <class E>
+    Array(const Expr<E>& e) : data_(e.self().size()) { assign(e.self()); }
+    template <class E>
+    Array& operator=(const Expr<E>& e) {
+        // 大小不同才重新配置；這時運算式不可能參照自己 (Binary 建立時已經檢查過所有陣列一樣長)
+        // 只有純量的運算式 (a = Scalar(0)) 沒有長度，保留原本大小，每個位置填同一個值
+        if (!E::broadcast && data_.size() != e.self().size()) data_.resize(e.self().size());
+        assign(e.self());
+        return *this;
+    }
+    template <class E> Array& operator+=(const Expr<E>& e) { return *this = *this + e.self(); }
+    template <class E> Array& operator-=(const Expr<E>& e) { return *this = *this - e.self(); }
+    template <class E> Array& operator*=(const Expr<E>& e) { return *this = *this * e.self(); }
+
+    T operator[](size_t i) const { return data_[i]; }
+    T& operator[](size_t i) { return data_[i]; }
+    size_t size() const { return data_.size(); }
+    T* data() { return data_.data(); }
+    const T* data() const { return data_.data(); }
+
+private:
+    vector<T> data_;
+
+    // 運算式可能讀到自己 (a = a + b，+= 也是展開成 *this = *this + e)，所以 out 不能加 __restrict
+    // 逐元素計算 out[i] 只依賴各陣列的第 i 個，同位置讀寫沒問題；GCC 會在執行時檢查重疊再走向量化版本
+    template <class E>
+    void assign(const E& e) {
+        if (!E::broadcast && e.size() != data_.size())
+            throw length_error("Array: 運算式長度和陣列不同");
+        T* out = data_.data();
+        size_t n = data_.size();
+        for (size_t i = 0; i < n; i++) out[i] = e[i];
+    }
+};
+
+// 純量：a * 2.0 裡的 2.0，每個位置都回傳同一個值
+template <class T>
+struct Scalar : Expr<Scalar<T>> {
+    static const bool broadcast = true;
+    T v;
+    explicit Scalar(T v) : v(v) {}
+    T operator[](size_t) const { return v; }
+    size_t size() const { return 0; }   // 不限長度，由另一邊決定
+};
+
+// 陣列存參照，其他運算式(暫時物件)存值，避免參照到已經消失的暫時物件
+template <class E> struct ExprRef { typedef const E type; };
+template <class T> struct ExprRef<Array<T>> { typedef const Array<T>& type; };
+
+template <class Op, class L, class R>
+struct Binary : Expr<Binary<Op, L, R>> {
+    typename ExprRef<L>::type l;
+    typename ExprRef<R>::type r;
+    static const bool broadcast = L::broadcast && R::broadcast;
+    // 兩邊都是陣列時長度必須相同，不然 a(10) + b(5) 會讀超出 b 的範圍
+    Binary(const L& l, const R& r) : l(l), r(r) {
+        if (!L::broadcast && !R::broadcast && l.size() != r.size())
+            throw length_error("Binary: 兩邊陣列長度不同");
+    }
+    auto operator[](size_t i) const { return Op::apply(l[i], r[i]); }
+    size_t size() const { return L::broadcast ? r.size() : l.size(); }
+};
+
+template <class Op, class E>
+struct Unary : Expr<Unary<Op, E>> {
+    typename ExprRef<E>::type e;
+    static const bool broadcast = E::broadcast;
+    explicit Unary(const E& e) : e(e) {}
+    auto operator[](size_t i) const { return Op::apply(e[i]); }
+    size_t size() const { return e.size(); }
+};
+
+struct AddOp { template <class A, class B> static auto apply(A a, B b) { return a + b; } };
+struct SubOp { template <class A, class B> static auto apply(A a, B b) { return a - b; } };
+struct MulOp { template <class A, class B> static auto apply(A a, B b) { return a * b; } };
+struct DivOp { template <class A, class B> static auto apply(A a, B b) { return a / b; } };
+struct MinOp { template <class A, class B> static auto apply(A a, B b) { return a < b ? a : b; } };  // 不用 std::min，它回傳參照
+struct MaxOp { template <class A, class B> static auto apply(A a, B b) { return a < b ? b : a; } };
+struct NegOp { template <class A> static auto apply(A a) { return -a; } };
+
+// 運算式 op 運算式、運算式 op 純量、純量 op 運算式
+#define EXPR_BINARY(NAME, OP)                                                                   \
+    template <class L, class R>                                                                 \
+    Binary<OP, L, R> NAME(const Expr<L>& l, const Expr<R>& r) {                                 \
+        return Binary<OP, L, R>(l.self(), r.self());                                            \
+    }                                                                                           \
+    template <class L, class S, class = typename enable_if<is_arithmetic<S>::value>::type>      \
+    Binary<OP, L, Scalar<S>> NAME(const Expr<L>& l, S s) {                                      \
+        return Binary<OP, L, Scalar<S>>(l.self(), Scalar<S>(s));                                \
+    }                                                                                           \
+    template <class S, class R, class = typename enable_if<is_arithmetic<S>::value>::type>      \
+    Binary<OP, Scalar<S>, R> NAME(S s, const Expr<R>& r) {                                      \
+        return Binary<OP, Scalar<S>, R>(Scalar<S>(s), r.self());                                \
+    }
+
+EXPR_BINARY(operator+, AddOp)
+EXPR_BINARY(operator-, SubOp)
+EXPR_BINARY(operator*, MulOp)
+EXPR_BINARY(operator/, DivOp)
+// 逐元素的 min/max 叫 vmin/vmax：using namespace std 之下 min(d, e) 兩邊同型態時會選到 std::min
+EXPR_BINARY(vmin, MinOp)
+EXPR_BINARY(vmax, MaxOp)
+#undef EXPR_BINARY   // 巨集只在這裡用來產生重複的多載，用完就取消定義
+
+template <class E>
+Unary<NegOp, E> operator-(const Expr<E>& e) { return Unary<NegOp, E>(e.self()); }
+
+//---------------- 歸約 (reduction) ----------------
+// 直接對運算式歸約，也不會產生暫存陣列：sum(a * b) 就是 dot
+// min(e)/max(e) 只有一個參數，不會和 std::min(a, b) 衝突
+// 用 4 個累加器打斷相依鏈，浮點數不用 -ffast-math 也能同時算好幾個加法
+
+template <class E>
+auto sum(const Expr<E>& expr) {
+    const E& e = expr.self();
+    typedef decltype(e[0]) T;
+    T acc[4] = {T(), T(), T(), T()};
+    size_t n = e.size(), i = 0;
+    for (; i + 4 <= n; i += 4)
+        for (int k = 0; k < 4; k++) acc[k] += e[i + k];
+    for (; i < n; i++) acc[0] += e[i];
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+template <class Op, class E>
+auto reduce_minmax(const E& e, decltype(e[0]) init) {
+    typedef decltype(e[0]) T;
+    T acc[4] = {init, init, init, init};
+    size_t n = e.size(), i = 0;
+    for (; i + 4 <= n; i += 4)
+        for (int k = 0; k < 4; k++) acc[k] = Op::apply(acc[k], e[i + k]);
+    for (; i < n; i++) acc[0] = Op::apply(acc[0], e[i]);
+    return Op::apply(Op::apply(acc[0], acc[1]), Op::apply(acc[2], acc[3]));
+}
+
+template <class E>
+auto min(const Expr<E>& e) {
+    typedef decltype(e.self()[0]) T;
+    return reduce_minmax<MinOp>(e.self(), numeric_limits<T>::max());
+}
+
+template <class E>
+auto max(const Expr<E>& e) {
+    typedef decltype(e.self()[0]) T;
+    return reduce_minmax<MaxOp>(e.self(), numeric_limits<T>::lowest());
+}
+
+template <class L, class R>
+auto dot(const Expr<L>& l, const Expr<R>& r) { return sum(l * r); }
+
+//###################################
+//############ Benchmark ############
+//###################################
+
+// 對照組：每一步都產生一個新的 vector (沒有 expression template 時 operator 的寫法)
+vector<double> v_add(const vector<double>& a, const vector<double>& b) {
+    vector<double> r(a.size()); for (size_t i = 0; i < a.size(); i++) r[i] = a[i] + b[i]; return r;
+}
+vector<double> v_sub(const vector<double>& a, const vector<double>& b) {
+    vector<double> r(a.size()); for (size_t i = 0; i < a.size(); i++) r[i] = a[i] - b[i]; return r;
+}
+vector<double> v_mul(const vector<double>& a, const vector<double>& b) {
+    vector<double> r(a.size()); for (size_t i = 0; i < a.size(); i++) r[i] = a[i] * b[i]; return r;
+}
+vector<double> v_min(const vector<double>& a, const vector<double>& b) {
+    vector<double> r(a.size()); for (size_t i = 0; i < a.size(); i++) r[i] = std::min(a[i], b[i]); return r;
+}
+
+template <class F>
+double time_ms(F fn) {
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    // 用法：./expr [N] [次數]
+    size_t N = argc > 1 ? stoull(argv[1]) : 10000000;
+    int reps = argc > 2 ? stoi(argv[2]) : 10;
+
+    mt19937 rng(42);
+    uniform_real_distribution<double> dist(-1.0, 1.0);
+    vector<double> va(N), vb(N), vc(N), vd(N), ve(N);
+    for (size_t i = 0; i < N; i++) { va[i] = dist(rng); vb[i] = dist(rng); vc[i] = dist(rng); vd[i] = dist(rng); ve[i] = dist(rng); }
+
+    Array<double> a(N), b(N), c(N), d(N), e(N), r;
+    for (size_t i = 0; i < N; i++) { a[i] = va[i]; b[i] = vb[i]; c[i] = vc[i]; d[i] = vd[i]; e[i] = ve[i]; }
+
+    // r = a + b * c - vmin(d, e)
+    vector<double> vr;
+    double t_naive = time_ms([&]{ for (int k = 0; k < reps; k++) vr = v_sub(v_add(va, v_mul(vb, vc)), v_min(vd, ve)); });
+    double t_expr = time_ms([&]{ for (int k = 0; k < reps; k++) r = a + b * c - vmin(d, e); });
+    bool ok = true;
+    // 融合成一個迴圈後編譯器可能用 FMA (乘加一次捨入)，和分開算的結果差在最後幾個 bit
+    for (size_t i = 0; i < N; i++) ok &= fabs(r[i] - vr[i]) < 1e-12;
+    printf("N = %zu, %d 次\n", N, reps);
+    printf("r = a + b * c - vmin(d, e) 暫存 vector %8.1f ms  expression template %8.1f ms  %s\n",
+           t_naive, t_expr, ok ? "結果相同" : "結果錯誤!");
+
+    // 歸約
+    double s1 = 0, s2 = 0;
+    double t_dot_naive = time_ms([&]{
+        for (int k = 0; k < reps; k++) { vector<double> m = v_mul(va, vb); double s = 0; for (double x : m) s += x; s1 = s; }
+    });
+    double t_dot_expr = time_ms([&]{ for (int k = 0; k < reps; k++) s2 = dot(a, b); });
+    printf("dot(a, b)                  暫存 vector %8.1f ms  expression template %8.1f ms  差 %.2e\n",
+           t_dot_naive, t_dot_expr, s1 - s2);   // 加法順序不同，浮點數誤差很小但不一定為 0
+
+    printf("sum = %.4f  min = %.4f  max = %.4f\n", sum(a + b), min(a * 2.0), max(-a));
+}
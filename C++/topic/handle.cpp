@@ -0,0 +1,104 @@
+#ifndef HANDLE_AUDIT
+#define HANDLE_AUDIT   // 這個示範就是要看計數，一定開啟
+#endif
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include "handle.h"   // "" 表示和這個 .cpp 檔同一個資料夾
+
+using namespace std;
+
+// 比較 class.cpp 的 MyClass 改寫前後，放進容器、排序、傳遞、複製時各發生幾次複製和配置
+//   g++ -O2 handle.cpp && ./a.out [物件數] [每個 buffer 幾個 int]
+
+// 改寫前：int* b 自己 new/delete，照 rule of three 寫了 copy，但沒有 move
+// 有自己寫 copy constructor 時 compiler 不會產生 move，vector 擴充、sort 都只能深層複製
+struct Before : handle::Counted<Before> {
+    int a;
+    int* b;
+    size_t n;
+    Before(int a, size_t n) : a(a), b(new int[n]()), n(n) { handle::note_alloc<Before>(); }
+    Before(const Before& o) : Counted(o), a(o.a), b(new int[o.n]), n(o.n) {
+        copy(o.b, o.b + n, b);
+        handle::note_alloc<Before>();
+    }
+    Before& operator=(const Before& o) {
+        if (this == &o) return *this;
+        Counted::operator=(o);
+        int* nb = new int[o.n];
+        copy(o.b, o.b + o.n, nb);
+        handle::note_alloc<Before>();
+        delete[] b;
+        b = nb;
+        n = o.n;
+        a = o.a;
+        return *this;
+    }
+    ~Before() { delete[] b; }
+    void set(size_t i, int v) { b[i] = v; }
+};
+
+// 改寫後：和 class.cpp 的 MyClass 一樣，CowBuffer 管理記憶體，其他交給 compiler (rule of zero)
+struct After : handle::Counted<After> {
+    int a;
+    handle::CowBuffer<int> b;
+    After(int a, size_t n) : a(a), b(n) {}
+    void set(size_t i, int v) { b.set(i, v); }
+};
+
+template <class X>
+vector<X> pass_through(vector<X> v) { return v; }   // 傳值進來、傳值出去 (搬移整個 vector，元素不動)
+
+template <class F>
+double time_ms(F fn) {
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+template <class X>
+void run(const char* name, size_t N, size_t len) {
+    mt19937 rng(7);
+    handle::reset();
+    long long check = 0;
+    double t = time_ms([&]{
+        vector<X> v;                                            // 沒有 reserve，會擴充好幾次
+        for (size_t i = 0; i < N; i++) v.push_back(X(int(rng() % 1000000), len));
+        sort(v.begin(), v.end(), [](const X& x, const X& y) { return x.a < y.a; });
+        vector<X> w = pass_through(std::move(v));
+        vector<X> snapshot = w;                                  // 邏輯上複製一份
+        snapshot[0].set(0, 42);                                  // 只改其中一個
+        check = snapshot[0].b[0] + w[0].b[0] + w.back().a;
+    });
+    printf("\n%s：%.1f ms  (check %lld)\n", name, t, check);
+    handle::report();
+}
+
+// Ref：reference count 放在物件裡，多個容器共用同一個物件
+struct Shape : handle::RefCounted<Shape>, handle::Counted<Shape> {
+    double w, h;
+    Shape(double w, double h) : w(w), h(h) {}
+};
+
+int main(int argc, char** argv) {
+    size_t N = argc > 1 ? strtoull(argv[1], nullptr, 10) : 200000;
+    size_t len = argc > 2 ? strtoull(argv[2], nullptr, 10) : 16;
+    printf("N = %zu 個物件，每個 %zu 個 int\n", N, len);
+
+    run<Before>("改寫前 (int* b + rule of three)", N, len);
+    run<After>("改寫後 (CowBuffer + rule of zero)", N, len);
+
+    handle::reset();
+    {
+        handle::Ref<Shape> s = handle::make_ref<Shape>(2.0, 3.0);
+        vector<handle::Ref<Shape>> all(1000, s), big;   // 1000 個 handle 指向同一個物件
+        for (auto& r : all) if (r->w * r->h > 5) big.push_back(r);
+        printf("\nRef<Shape>：use_count = %u (s + all + big)\n", s.use_count());
+    }
+    handle::report();
+    // 程式結束時，還沒解構的 Counted 物件和 CowBuffer 會印到 stderr (例如忘記 delete 或 release() 之後沒有釋放)
+}
@@ -0,0 +1,313 @@
+#ifndef HANDLE_H   //避免重複引入
+#define HANDLE_H
+
+//###################################
+//############## Handle #############
+//###################################
+
+// 取代 class 裡的 raw pointer (例如 int* b)：誰負責 delete、複製時怎麼辦，交給 handle 決定
+//
+//   Unique<T>      只有一個擁有者，不能複製、只能搬移 (move)，離開 scope 自動 delete
+//   Ref<T>         多個擁有者共用，reference count 放在物件裡 (T 繼承 RefCounted<T>)
+//                  和 shared_ptr 比：不用另外配置 control block，handle 本身只有一個 pointer
+//   CowBuffer<T>   copy-on-write 陣列：複製只加 reference count，要修改時才真的複製 (只有自己在用就直接改)
+//
+//   handle::make_unique<T>(...)、handle::make_ref<T>(...) 建立物件
+//
+// 有了這些成員，class 不需要自己寫 copy/move constructor 和 destructor (rule of zero)，
+// compiler 產生的版本就是對的，搬移也會自動是 noexcept，放進 vector 擴充時就會用搬移而不是複製
+//
+// 計數模式：編譯時加 -DHANDLE_AUDIT
+//   class 繼承 handle::Counted<T> 後，會記錄 T 被建構、複製、搬移、解構幾次，以及 make_unique/make_ref 配置幾次
+//   CowBuffer<T> 記錄配置幾塊 buffer、真正複製資料 (copy-on-write 觸發) 幾次；共用 buffer 的複製不算
+//   handle::report() 印出目前的統計，程式結束時還活著的物件 (可能是 leak) 會自動列出來
+//   沒有定義 HANDLE_AUDIT 時 Counted<T> 是空的 class，不佔空間也沒有任何成本
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+#ifdef HANDLE_AUDIT
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#if defined(__GNUG__)
+#include <cstdlib>
+#include <cxxabi.h>   // 把 typeid 的名稱轉回看得懂的型態名稱
+#endif
+#endif
+
+namespace handle {
+
+#ifdef HANDLE_AUDIT
+
+struct Stats {
+    std::string name;
+    std::atomic<size_t> constructs{0}, copies{0}, moves{0}, destroys{0}, allocs{0};   // 複製、搬移包含 operator=
+    std::atomic<long long> live{0};   // 目前還沒解構的數量
+};
+
+inline void report_leaks();
+
+struct Registry {
+    std::mutex mu;
+    std::vector<Stats*> all;
+    ~Registry() { report_leaks(); }   // 程式結束時檢查
+};
+inline Registry& registry() { static Registry r; return r; }
+
+inline std::string type_name(const char* mangled) {
+#if defined(__GNUG__)
+    int status = 0;
+    char* s = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+    std::string r = status == 0 ? s : mangled;
+    std::free(s);
+    return r;
+#else
+    return mangled;
+#endif
+}
+
+// 每個型態一份統計，第一次用到時登記
+template <class T>
+Stats& stats() {
+    static Stats* s = [] {
+        Stats* p = new Stats;   // 不釋放，程式結束時 Registry 還要讀
+        p->name = type_name(typeid(T).name());
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mu);
+        reg.all.push_back(p);
+        return p;
+    }();
+    return *s;
+}
+
+inline void report(FILE* f = stdout) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mu);
+    // 中文字 UTF-8 佔 3 bytes 但只佔 2 格寬，printf 以 bytes 計算寬度，標題的寬度要多給
+    std::fprintf(f, "%-30s %12s %12s %12s %12s %12s %10s\n", "型態", "建構", "複製", "搬移", "解構", "heap 配置", "存活");
+    for (Stats* s : reg.all)
+        std::fprintf(f, "%-28s %10zu %10zu %10zu %10zu %10zu %8lld\n", s->name.c_str(), s->constructs.load(),
+                     s->copies.load(), s->moves.load(), s->destroys.load(), s->allocs.load(), s->live.load());
+}
+
+// 計數歸零 (比較不同階段時用)，存活的數量不清掉
+inline void reset() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mu);
+    for (Stats* s : reg.all) s->constructs = s->copies = s->moves = s->destroys = s->allocs = 0;
+}
+
+inline void report_leaks() {
+    Registry& reg = registry();
+    for (Stats* s : reg.all)
+        if (s->live > 0)
+            std::fprintf(stderr, "[handle] %s 結束時還有 %lld 個沒有解構 (可能是 leak)\n", s->name.c_str(), s->live.load());
+}
+
+template <class T> inline void note_alloc() { stats<T>().allocs++; }
+
+// 繼承這個 class 就會被計數：class MyClass : public handle::Counted<MyClass>
+template <class T>
+struct Counted {
+    Counted() { stats<T>().constructs++; stats<T>().live++; }
+    Counted(const Counted&) { stats<T>().copies++; stats<T>().live++; }
+    Counted(Counted&&) noexcept { stats<T>().moves++; stats<T>().live++; }
+    Counted& operator=(const Counted&) { stats<T>().copies++; return *this; }
+    Counted& operator=(Counted&&) noexcept { stats<T>().moves++; return *this; }
+    ~Counted() { stats<T>().destroys++; stats<T>().live--; }
+};
+
+#else   // 沒有 -DHANDLE_AUDIT：全部是空的
+
+inline void report(FILE* = stdout) {}
+inline void reset() {}
+template <class T> inline void note_alloc() {}
+template <class T> struct Counted {};
+
+#endif  // HANDLE_AUDIT
+
+//---------------- Unique ----------------
+
+template <class T>
+class Unique {
+public:
+    Unique() : p_(nullptr) {}
+    explicit Unique(T* p) : p_(p) {}
+    Unique(Unique&& o) noexcept : p_(o.release()) {}
+    // Unique<derived> 可以轉成 Unique<base>，base 必須有 virtual destructor，delete 時才會呼叫到 derived 的
+    template <class U, class = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+    Unique(Unique<U>&& o) noexcept : p_(o.release()) {
+        static_assert(std::is_same<U, T>::value || std::has_virtual_destructor<T>::value,
+                      "base class 需要 virtual destructor");
+    }
+    Unique& operator=(Unique&& o) noexcept { reset(o.release()); return *this; }
+    Unique(const Unique&) = delete;
+    Unique& operator=(const Unique&) = delete;
+    ~Unique() { delete p_; }
+
+    T* get() const { return p_; }
+    T& operator*() const { return *p_; }
+    T* operator->() const { return p_; }
+    explicit operator bool() const { return p_ != nullptr; }
+
+    T* release() { T* p = p_; p_ = nullptr; return p; }   // 放棄擁有權，之後要自己 delete
+    void reset(T* p = nullptr) { T* old = p_; p_ = p; delete old; }
+
+private:
+    T* p_;
+};
+
+template <class T, class... A>
+Unique<T> make_unique(A&&... args) {
+    note_alloc<T>();
+    return Unique<T>(new T(std::forward<A>(args)...));
+}
+
+//---------------- Ref ----------------
+
+template <class T> class Ref;
+
+// 要被 Ref 管理的 class 繼承它：class Node : public handle::RefCounted<Node>
+template <class T>
+class RefCounted {
+protected:
+    RefCounted() = default;
+    RefCounted(const RefCounted&) {}                              // 複製物件時計數從 0 開始，不跟著複製
+    RefCounted& operator=(const RefCounted&) { return *this; }
+    ~RefCounted() = default;
+private:
+    template <class> friend class Ref;
+    mutable std::atomic<uint32_t> refs_{0};
+};
+
+template <class T>
+class Ref {
+public:
+    Ref() : p_(nullptr) {}
+    explicit Ref(T* p) : p_(p) { retain(); }
+    Ref(const Ref& o) : p_(o.p_) { retain(); }
+    Ref(Ref&& o) noexcept : p_(o.p_) { o.p_ = nullptr; }
+    template <class U, class = typename std::enable_if<std::is_convertible<U*, T*>::value>::type>
+    Ref(Ref<U> o) noexcept : p_(o.p_) {
+        static_assert(std::is_same<U, T>::value || std::has_virtual_destructor<T>::value,
+                      "base class 需要 virtual destructor");
+        o.p_ = nullptr;
+    }
+    Ref& operator=(Ref o) noexcept { std::swap(p_, o.p_); return *this; }   // 複製和搬移共用 (copy-and-swap)
+    ~Ref() { release(); }
+
+    T* get() const { return p_; }
+    T& operator*() const { return *p_; }
+    T* operator->() const { return p_; }
+    explicit operator bool() const { return p_ != nullptr; }
+    uint32_t use_count() const { return p_ ? p_->refs_.load(std::memory_order_relaxed) : 0; }
+
+private:
+    template <class> friend class Ref;
+    T* p_;
+
+    void retain() { if (p_) p_->refs_.fetch_add(1, std::memory_order_relaxed); }
+    // 最後一個擁有者負責 delete；acq_rel 讓其他 thread 對物件的修改在 delete 前都看得到
+    void release() {
+        if (p_ && p_->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) delete p_;
+        p_ = nullptr;
+    }
+};
+
+template <class T, class... A>
+Ref<T> make_ref(A&&... args) {
+    note_alloc<T>();
+    return Ref<T>(new T(std::forward<A>(args)...));
+}
+
+//---------------- CowBuffer ----------------
+
+// 一塊記憶體：[Header][T T T ...]，reference count 和資料一起配置，只要一次 new
+template <class T>
+class CowBuffer {
+    static_assert(std::is_trivially_copyable<T>::value, "CowBuffer 只放 trivially copyable 的型態 (用 memcpy 複製)");
+public:
+    CowBuffer() : h_(nullptr) {}
+    explicit CowBuffer(size_t n, const T& v = T()) : h_(allocate(n)) {
+        for (size_t i = 0; i < n; i++) elems()[i] = v;
+    }
+    CowBuffer(const T* p, size_t n) : h_(allocate(n)) { if (n) std::memcpy(elems(), p, n * sizeof(T)); }
+    CowBuffer(std::initializer_list<T> il) : CowBuffer(il.begin(), il.size()) {}
+
+    CowBuffer(const CowBuffer& o) : h_(o.h_) { if (h_) h_->refs.fetch_add(1, std::memory_order_relaxed); }   // 不複製資料
+    CowBuffer(CowBuffer&& o) noexcept : h_(o.h_) { o.h_ = nullptr; }
+    CowBuffer& operator=(CowBuffer o) noexcept { std::swap(h_, o.h_); return *this; }
+    ~CowBuffer() { release(); }
+
+    size_t size() const { return h_ ? h_->size : 0; }
+    bool empty() const { return size() == 0; }
+    const T* data() const { return h_ ? elems() : nullptr; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size(); }
+    const T& operator[](size_t i) const { return elems()[i]; }
+    size_t use_count() const { return h_ ? h_->refs.load(std::memory_order_relaxed) : 0; }
+
+    // 要修改時才呼叫：別人也在用就先複製一份自己的
+    T* mutable_data() { detach(); return h_ ? elems() : nullptr; }
+    void set(size_t i, const T& v) { mutable_data()[i] = v; }
+
+private:
+    struct Header {
+        std::atomic<uint32_t> refs;
+        size_t size;
+    };
+    // 資料從 Header 後面、對齊 T 的位置開始
+    static constexpr size_t OFFSET = (sizeof(Header) + alignof(T) - 1) / alignof(T) * alignof(T);
+    Header* h_;
+
+    T* elems() const { return reinterpret_cast<T*>(reinterpret_cast<char*>(h_) + OFFSET); }
+
+    static Header* allocate(size_t n, bool is_copy = false) {
+        if (n == 0) return nullptr;
+        void* m = ::operator new(OFFSET + n * sizeof(T));
+        Header* h = new (m) Header;
+        h->refs.store(1, std::memory_order_relaxed);
+        h->size = n;
+#ifdef HANDLE_AUDIT
+        Stats& st = stats<CowBuffer>();
+        (is_copy ? st.copies : st.constructs)++;
+        st.allocs++;
+        st.live++;
+#else
+        (void)is_copy;
+#endif
+        return h;
+    }
+
+    void release() {
+        if (h_ && h_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            h_->~Header();
+            ::operator delete(h_);
+#ifdef HANDLE_AUDIT
+            stats<CowBuffer>().destroys++;
+            stats<CowBuffer>().live--;
+#endif
+        }
+        h_ = nullptr;
+    }
+
+    void detach() {
+        if (!h_ || h_->refs.load(std::memory_order_acquire) == 1) return;   // 只有自己在用，直接改
+        Header* n = allocate(h_->size, true);   // 計數模式下算成「複製」
+        std::memcpy(reinterpret_cast<char*>(n) + OFFSET, elems(), h_->size * sizeof(T));
+        release();
+        h_ = n;
+    }
+};
+
+}  // namespace handle
+
+#endif  // HANDLE_H
@@ -0,0 +1,344 @@
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <type_traits>
+
+using namespace std;
+
+//###################################
+//############ NaN Boxing ###########
+//###################################
+
+// advance.cpp 的 union data {int a[2]; char b;}; 讓成員共用記憶體，但沒有記錄「現在存的是哪一個」
+// 讀錯成員是未定義行為；std::variant 多存了一個 tag 所以安全，但 variant<int64_t,double,bool,string> 要 40 bytes
+//
+// NaN boxing：double 是 64 bit，IEEE 754 規定 exponent 全為 1 且 mantissa 不為 0 時是 NaN
+// 真正的運算只需要一種 NaN，剩下將近 2^51 種 NaN 的 bit 組合可以拿來放其他型態：
+//
+//   一般的 double          直接存 (NaN 一律轉成標準的 0x7FF8000000000000)
+//   0xFFF8 | tag<<48 | payload
+//        ^^^^ 13 個 1 (負號 + exponent + quiet bit)，後面 3 bit 是 tag，剩下 48 bit 是資料
+//
+// 48 bit 放得下：48 bit 整數、bool、5 個字以內的短字串、x86-64/ARM64 的使用者空間 pointer
+// 所以 sizeof(Value) == 8，而且每次讀取都會先檢查 tag，型態不對就丟例外，不會像 union 讀到亂碼
+//
+// 注意：短字串直接放在 Value 的 byte 裡 (假設 little-endian)；長字串放在 heap，用 reference count 共用
+
+class Value {
+public:
+    enum Type { NIL, BOOL, INT, SMALL_STR, STR, PTR, DOUBLE };   // 前 6 個就是 tag 的值
+
+    static const int64_t INT_MAX48 = (int64_t(1) << 47) - 1;
+    static const int64_t INT_MIN48 = -(int64_t(1) << 47);
+    static const size_t SMALL_MAX = 5;
+
+    Value() : bits_(box(NIL, 0)) {}
+    Value(nullptr_t) : Value() {}
+    Value(bool b) : bits_(box(BOOL, b)) {}
+    // 所有整數型態 (long long、size_t、unsigned、short...) 共用一個建構子，只分別寫 int、int64_t 的話
+    // Value v = 42LL 或 Value(size_t) 會有好幾個同樣好的轉換而 ambiguous；bool 另外處理
+    template <class I, class = enable_if_t<is_integral<I>::value && !is_same<I, bool>::value>>
+    Value(I i) {
+        bool fits;
+        if constexpr (is_signed<I>::value) fits = int64_t(i) >= INT_MIN48 && int64_t(i) <= INT_MAX48;
+        else fits = uint64_t(i) <= uint64_t(INT_MAX48);   // 不能先轉成 int64_t，超過 2^63 的 size_t 會變負數
+        if (!fits) throw out_of_range("Value: 整數超過 48 bit");
+        bits_ = box(INT, uint64_t(int64_t(i)) & PAYLOAD);
+    }
+    Value(double d) {
+        if (d != d) { bits_ = CANONICAL_NAN; return; }   // 所有 NaN 都變成同一個，才不會撞到 tag
+        memcpy(&bits_, &d, 8);
+    }
+    Value(string_view s) {
+        if (s.size() <= SMALL_MAX) {
+            uint64_t p = uint64_t(s.size()) << 40;
+            memcpy(&p, s.data(), s.size());            // 低 5 個 byte 放字元
+            bits_ = box(SMALL_STR, p);
+        } else {
+            bits_ = box(STR, reinterpret_cast<uint64_t>(HeapStr::make(s)));
+        }
+    }
+    Value(const char* s) : Value(string_view(s)) {}
+    Value(const string& s) : Value(string_view(s)) {}
+    Value(void* p) {                                    // 不擁有的 pointer，Value 不會 delete 它
+        uint64_t u = reinterpret_cast<uint64_t>(p);
+        if (u & ~PAYLOAD) throw invalid_argument("Value: pointer 超過 48 bit");
+        bits_ = box(PTR, u);
+    }
+
+    Value(const Value& o) : bits_(o.bits_) { retain(); }
+    Value(Value&& o) noexcept : bits_(o.bits_) { o.bits_ = box(NIL, 0); }
+    Value& operator=(const Value& o) { Value(o).swap(*this); return *this; }
+    Value& operator=(Value&& o) noexcept { Value(std::move(o)).swap(*this); return *this; }
+    ~Value() { release(); }
+    void swap(Value& o) noexcept { std::swap(bits_, o.bits_); }
+
+    Type type() const { return is_boxed() ? Type((bits_ >> 48) & 7) : DOUBLE; }
+    bool is_nil() const { return bits_ == box(NIL, 0); }
+    bool is_bool() const { return type() == BOOL; }
+    bool is_int() const { return type() == INT; }
+    bool is_double() const { return !is_boxed(); }
+    bool is_number() const { return is_int() || is_double(); }
+    bool is_string() const { Type t = type(); return t == SMALL_STR || t == STR; }
+    bool is_ptr() const { return type() == PTR; }
+
+    // 型態不對就丟 bad_value (union 則是直接讀出錯的 bit)
+    struct bad_value : logic_error { using logic_error::logic_error; };
+
+    bool as_bool() const { check(BOOL); return bits_ & 1; }
+    int64_t as_int() const { check(INT); return unchecked_int(); }
+    double as_double() const { if (!is_double()) throw bad_value("Value: 不是 double"); return unchecked_double(); }
+    double as_number() const { return is_int() ? double(as_int()) : as_double(); }   // int 自動轉 double
+    void* as_ptr() const { check(PTR); return reinterpret_cast<void*>(bits_ & PAYLOAD); }
+
+    // 回傳的 string_view 在 Value 存活期間有效 (短字串指向 Value 本身)
+    string_view as_string() const {
+        Type t = type();
+        if (t == SMALL_STR) return string_view(reinterpret_cast<const char*>(&bits_), (bits_ >> 40) & 7);
+        if (t == STR) { const HeapStr* h = heap(); return string_view(h->data(), h->len); }
+        throw bad_value("Value: 不是字串");
+    }
+
+    // 已經確定型態時用的快速版本，不檢查 tag
+    int64_t unchecked_int() const { return int64_t(bits_ << 16) >> 16; }   // 48 bit 有號數延伸回 64 bit
+    double unchecked_double() const { double d; memcpy(&d, &bits_, 8); return d; }
+    uint64_t raw_bits() const { return bits_; }
+
+    friend bool operator==(const Value& a, const Value& b) {
+        if (a.bits_ == b.bits_) return !(a.is_double() && a.unchecked_double() != a.unchecked_double());  // NaN != NaN
+        if (a.is_double() && b.is_double()) return a.unchecked_double() == b.unchecked_double();        // 0.0 == -0.0
+        if (a.type() == STR && b.type() == STR) return a.as_string() == b.as_string();
+        return false;   // 其餘型態的 bit 都是唯一表示法，bit 不同就是不同
+    }
+    friend bool operator!=(const Value& a, const Value& b) { return !(a == b); }
+
+    friend ostream& operator<<(ostream& os, const Value& v) {
+        switch (v.type()) {
+            case NIL:    return os << "nil";
+            case BOOL:   return os << (v.as_bool() ? "true" : "false");
+            case INT:    return os << v.as_int();
+            case DOUBLE: return os << v.as_double();
+            case PTR:    return os << v.as_ptr();
+            default:     return os << '"' << v.as_string() << '"';
+        }
+    }
+
+private:
+    static const uint64_t BOXED = 0xFFF8000000000000ULL;
+    static const uint64_t PAYLOAD = 0x0000FFFFFFFFFFFFULL;
+    static const uint64_t CANONICAL_NAN = 0x7FF8000000000000ULL;
+
+    // 長字串：[reference count][長度][字元...]，一次 malloc
+    struct HeapStr {
+        uint32_t refs;
+        uint32_t len;
+        char* data() { return reinterpret_cast<char*>(this + 1); }
+        const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+        static HeapStr* make(string_view s) {
+            if (s.size() > UINT32_MAX) throw length_error("Value: 字串太長");
+            HeapStr* h = static_cast<HeapStr*>(malloc(sizeof(HeapStr) + s.size()));
+            if (!h) throw bad_alloc();
+            h->refs = 1;
+            h->len = uint32_t(s.size());
+            memcpy(h->data(), s.data(), s.size());
+            if (reinterpret_cast<uint64_t>(h) & ~PAYLOAD) { free(h); throw bad_alloc(); }
+            return h;
+        }
+    };
+
+    uint64_t bits_;
+
+    static uint64_t box(Type t, uint64_t payload) { return BOXED | (uint64_t(t) << 48) | payload; }
+    bool is_boxed() const { return (bits_ & BOXED) == BOXED; }
+    void check(Type t) const { if (type() != t) throw bad_value("Value: 型態不符"); }
+    HeapStr* heap() const { return reinterpret_cast<HeapStr*>(bits_ & PAYLOAD); }
+    void retain() { if (type() == STR) heap()->refs++; }
+    void release() { if (type() == STR && --heap()->refs == 0) free(heap()); }
+};
+
+//###################################
+//########### ValueVector ###########
+//###################################
+
+// vector<Value> 加上一個「出現過哪些型態」的 bit mask
+// 如果整個 vector 只有 int (或只有 double)，sum/find 就走不用檢查 tag 的迴圈
+class ValueVector {
+public:
+    void push_back(Value v) { types_ |= 1u << v.type(); items_.push_back(std::move(v)); }
+    void reserve(size_t n) { items_.reserve(n); }
+    size_t size() const { return items_.size(); }
+    const Value& operator[](size_t i) const { return items_[i]; }
+    vector<Value>::const_iterator begin() const { return items_.begin(); }
+    vector<Value>::const_iterator end() const { return items_.end(); }
+    size_t bytes() const { return items_.capacity() * sizeof(Value); }
+
+    // 被覆蓋掉的型態不從 mask 移除，mask 可能比實際多 (只會讓 sum/find 走比較慢但正確的路)
+    // 每次 set 都重掃整個 vector 會讓 n 次 set 變成 O(n^2)；需要時再呼叫 recompute_types() 一次重算
+    void set(size_t i, Value v) { types_ |= 1u << v.type(); items_[i] = std::move(v); }
+    void recompute_types() {
+        types_ = 0;
+        for (auto& x : items_) types_ |= 1u << x.type();
+    }
+
+    bool all_of(Value::Type t) const { return types_ == (1u << t); }
+
+    // 所有數字的總和 (非數字略過)
+    double sum() const {
+        if (all_of(Value::INT)) {
+            // 每個值 |x| <= 2^47，int64_t 只保證加 2^16 個不溢位 (有號數溢位是未定義行為)
+            // 所以每 65536 個一段用 int64_t 加 (迴圈簡單，可以向量化)，段落的和再加進 __int128
+            __int128 total = 0;
+            size_t n = items_.size();
+            for (size_t b = 0; b < n; b += 65536) {
+                size_t e = min(n, b + 65536);
+                int64_t s = 0;
+                for (size_t i = b; i < e; i++) s += items_[i].unchecked_int();
+                total += s;
+            }
+            return double(total);
+        }
+        if (all_of(Value::DOUBLE)) {
+            double s = 0;
+            for (auto& v : items_) s += v.unchecked_double();
+            return s;
+        }
+        double s = 0;
+        for (auto& v : items_) if (v.is_number()) s += v.as_number();
+        return s;
+    }
+
+    // 回傳第一個等於 x 的位置，沒有則回傳 size()
+    size_t find(const Value& x) const {
+        // 沒有 double 和長字串時，相等就等於 bit 相同，直接比 64-bit 整數
+        unsigned slow = (1u << Value::DOUBLE) | (1u << Value::STR);
+        if (!(types_ & slow) && !x.is_double() && x.type() != Value::STR) {
+            uint64_t b = x.raw_bits();
+            for (size_t i = 0; i < items_.size(); i++) if (items_[i].raw_bits() == b) return i;
+            return items_.size();
+        }
+        for (size_t i = 0; i < items_.size(); i++) if (items_[i] == x) return i;
+        return items_.size();
+    }
+
+private:
+    vector<Value> items_;
+    unsigned types_ = 0;
+};
+
+//###################################
+//############ ValueMap #############
+//###################################
+
+// 一筆 record：欄位編號 -> Value，欄位不多時排序好的 vector 比 map 省空間又快 (每欄 16 bytes)
+class ValueMap {
+public:
+    void set(uint32_t field, Value v) {
+        auto it = lower(field);
+        if (it != fields_.end() && it->first == field) it->second = std::move(v);
+        else fields_.insert(it, {field, std::move(v)});
+    }
+    const Value* get(uint32_t field) const {
+        auto it = lower_bound(fields_.begin(), fields_.end(), field,
+                              [](const pair<uint32_t, Value>& p, uint32_t f) { return p.first < f; });
+        return (it != fields_.end() && it->first == field) ? &it->second : nullptr;
+    }
+    size_t count(uint32_t field) const { return get(field) ? 1 : 0; }
+    size_t erase(uint32_t field) {
+        auto it = lower(field);
+        if (it == fields_.end() || it->first != field) return 0;
+        fields_.erase(it);
+        return 1;
+    }
+
+    // 型態專用的讀法：欄位不存在或型態不對就回傳預設值，不丟例外
+    int64_t get_int(uint32_t field, int64_t def = 0) const { auto v = get(field); return v && v->is_int() ? v->unchecked_int() : def; }
+    double get_double(uint32_t field, double def = 0) const { auto v = get(field); return v && v->is_number() ? v->as_number() : def; }
+    bool get_bool(uint32_t field, bool def = false) const { auto v = get(field); return v && v->is_bool() ? v->as_bool() : def; }
+    string_view get_string(uint32_t field, string_view def = {}) const { auto v = get(field); return v && v->is_string() ? v->as_string() : def; }
+
+    size_t size() const { return fields_.size(); }
+    vector<pair<uint32_t, Value>>::const_iterator begin() const { return fields_.begin(); }
+    vector<pair<uint32_t, Value>>::const_iterator end() const { return fields_.end(); }
+
+private:
+    vector<pair<uint32_t, Value>> fields_;
+    vector<pair<uint32_t, Value>>::iterator lower(uint32_t field) {
+        return lower_bound(fields_.begin(), fields_.end(), field,
+                           [](const pair<uint32_t, Value>& p, uint32_t f) { return p.first < f; });
+    }
+};
+
+//###################################
+//############ Benchmark ############
+//###################################
+
+typedef variant<monostate, bool, int64_t, double, string> StdValue;
+
+template <class F>
+double time_ms(F fn) {
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    // 用法：./nanbox [N]
+    size_t N = argc > 1 ? stoull(argv[1]) : 5000000;
+
+    static_assert(sizeof(Value) == 8, "Value 應為 8 bytes");
+    Value v1 = 42, v2 = 3.14, v3 = true, v4 = "abc", v5 = "caterpillar", v6 = nan("");
+    cout << v1 << " " << v2 << " " << v3 << " " << v4 << " " << v5 << " " << v6 << endl;
+    try {
+        v4.as_int();   // union 會讀出亂碼，Value 會丟例外
+    } catch (const Value::bad_value& e) {
+        cout << "as_int() on string: " << e.what() << endl;
+    }
+
+    ValueMap rec;
+    rec.set(1, "first_value");
+    rec.set(2, 10);
+    rec.set(3, 0.5);
+    cout << rec.get_string(1) << " " << rec.get_int(2) << " " << rec.get_double(3) << " " << rec.count(4) << endl;
+
+    // 混合型態的欄位：40% int、30% double、20% 短字串、10% bool
+    mt19937 rng(42);
+    ValueVector mixed, ints;
+    vector<StdValue> std_mixed;
+    mixed.reserve(N); ints.reserve(N); std_mixed.reserve(N);
+    const char* words[] = {"id", "ok", "name", "tag", "x"};
+    for (size_t i = 0; i < N; i++) {
+        unsigned r = rng() % 10;
+        if (r < 4)      { int64_t x = rng() % 1000; mixed.push_back(x); std_mixed.emplace_back(x); }
+        else if (r < 7) { double x = (rng() % 1000) / 8.0; mixed.push_back(x); std_mixed.emplace_back(x); }
+        else if (r < 9) { const char* w = words[rng() % 5]; mixed.push_back(w); std_mixed.emplace_back(string(w)); }
+        else            { bool b = rng() & 1; mixed.push_back(b); std_mixed.emplace_back(b); }
+        ints.push_back(int64_t(i % 1000));
+    }
+
+    double s1 = 0, s2 = 0, s3 = 0;
+    double t_std = time_ms([&]{
+        for (auto& v : std_mixed) {
+            if (auto p = get_if<int64_t>(&v)) s1 += double(*p);
+            else if (auto q = get_if<double>(&v)) s1 += *q;
+        }
+    });
+    double t_val = time_ms([&]{ s2 = mixed.sum(); });
+    double t_int = time_ms([&]{ s3 = ints.sum(); });
+
+    printf("N = %zu\n", N);
+    printf("sizeof: Value %zu, variant<monostate,bool,int64_t,double,string> %zu\n", sizeof(Value), sizeof(StdValue));
+    printf("vector<variant> %7.1f MB  sum %6.1f ms\n", N * sizeof(StdValue) / 1e6, t_std);
+    printf("ValueVector     %7.1f MB  sum %6.1f ms  %s\n", mixed.bytes() / 1e6, t_val, s1 == s2 ? "結果相同" : "結果錯誤!");
+    printf("ValueVector(全 int 快速路徑)  sum %6.1f ms  = %.0f\n", t_int, s3);
+    printf("find(\"tag\") = %zu\n", mixed.find("tag"));
+}
@@ -0,0 +1,46 @@
+#ifndef PARALLEL_H   //避免重複引入
+#define PARALLEL_H
+
+//###################################
+//############# Parallel ############
+//###################################
+
+// radix sort.cpp、range query.cpp、sparse matrix.cpp 共用：把一段 [0, n) 切給幾個 thread 做
+//   parallel_chunks(n, chunk_threads(n, threads), [&](unsigned t, size_t b, size_t e) { ... });
+// 工作量不平均時自己算切點，再交給 parallel_ranges (例如 sparse matrix 依非零元素個數切 row)
+// 編譯時記得加 -pthread
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// bounds 有 threads + 1 個遞增的切點，第 t 段 [bounds[t], bounds[t+1]) 交給一個 thread 執行 fn(t, begin, end)
+// 只有一段時直接在目前的 thread 執行，不建立 thread
+template <class F>
+void parallel_ranges(const std::vector<size_t>& bounds, F fn) {
+    unsigned threads = unsigned(bounds.size() - 1);
+    if (threads <= 1) { fn(0u, bounds.front(), bounds.back()); return; }
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++) pool.emplace_back(fn, t, bounds[t], bounds[t + 1]);
+    for (auto& th : pool) th.join();
+}
+
+// 把 [0, n) 平均切成 threads 段
+template <class F>
+void parallel_chunks(size_t n, unsigned threads, F fn) {
+    if (threads <= 1) { fn(0u, size_t(0), n); return; }
+    std::vector<size_t> bounds(threads + 1);
+    size_t step = (n + threads - 1) / threads;
+    for (unsigned t = 0; t <= threads; t++) bounds[t] = std::min(n, t * step);
+    parallel_ranges(bounds, fn);
+}
+
+// 實際要用幾個 thread：threads == 0 表示所有核心
+// 建立一個 thread 大約要幾十 µs，每個 thread 至少分到 min_chunk 個元素才值得
+inline unsigned chunk_threads(size_t n, unsigned threads, size_t min_chunk = 65536) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    return (unsigned)std::max<size_t>(1, std::min<size_t>(threads, n / min_chunk));
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include <iostream>
+#include "trace.h"   //編譯時加 -DTRACE 可記錄各段花費的時間 (見 trace.h)
 using namespace std;
 
 int a = 0;
@@ -23,12 +24,18 @@ int main() {
     //c+1會移動一個int也就是4bytes(0x裡+4)
     //宣告兩指標寫成 int *a, *b;
     
-    fun1(a);  //a=0 不變
-    fun2(&a); //a=1 有變(修改位址a的值)
-    fun3(a);  //a=2 有變(x為a的參考)
+    {
+        TRACE_SCOPE("call by value/address/reference");
+        fun1(a);  //a=0 不變
+        fun2(&a); //a=1 有變(修改位址a的值)
+        fun3(a);  //a=2 有變(x為a的參考)
+    }
     
-    fun4(&c); //pointer c 改指向 d (*c=10)
-    fun5(c);  //pointer c 改指向 a (*c=2)
+    {
+        TRACE_SCOPE("pointer to pointer/reference to pointer");
+        fun4(&c); //pointer c 改指向 d (*c=10)
+        fun5(c);  //pointer c 改指向 a (*c=2)
+    }
     
     /*
     ##########################
@@ -95,4 +102,5 @@ int main() {
     printf("%p\n",(a[0]+1)); //0x04 (移動  1個int  4bytes)
     
     */
+    TRACE_DUMP("trace.json");
 }
@@ -0,0 +1,228 @@
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include <chrono>
+#include <random>
+#include <numeric>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "parallel.h"   //parallel_chunks、chunk_threads (和 range query.cpp 共用)
+
+using namespace std;
+
+//###################################
+//############ Radix Sort ###########
+//###################################
+
+// sort() 是比較排序 (introsort)，平均 O(n log n) 次比較
+// LSD (Least Significant Digit) radix sort 不做比較，每次取 key 的一個 byte 當作桶子(0~255)
+// 由最低位 byte 排到最高位 byte，每一輪都是 stable 的計數排序，總共 sizeof(key) 輪，為 O(n*k)
+//
+// 每一輪分兩步：
+//   histogram: 數每個桶子有幾個元素
+//   scatter:   依前綴和 (prefix sum) 算出每個桶子的起點，把元素搬到暫存陣列
+// 兩步都可以把陣列切成幾段給不同 thread 做，每個 thread 各自有一份 histogram
+// 起點依 (桶子, thread) 的順序排，這樣搬完之後仍然是 stable 的
+
+// radix 只認得 unsigned 整數的 bit 順序，其他型態要先轉成「bit 大小順序 = 數值大小順序」的 unsigned
+//   unsigned: 不用轉
+//   signed:   最高位(sign bit)翻轉，負數就會排在正數前面
+//   float:    正數翻 sign bit，負數全部 bit 翻轉 (IEEE 754 負數越大 bit 越小)
+template <class T, class Enable = void> struct RadixKey;
+
+template <class T>
+struct RadixKey<T, typename enable_if<is_integral<T>::value>::type> {
+    typedef typename make_unsigned<T>::type U;
+    static U encode(T x) {
+        U u = static_cast<U>(x);
+        if (is_signed<T>::value) u ^= U(1) << (sizeof(U) * 8 - 1);
+        return u;
+    }
+};
+
+template <class T>
+struct RadixKey<T, typename enable_if<is_floating_point<T>::value>::type> {
+    typedef typename conditional<sizeof(T) == 4, uint32_t, uint64_t>::type U;
+    static U encode(T x) {
+        U u;
+        memcpy(&u, &x, sizeof(u));  // 不用 *(U*)&x，那是 strict aliasing 的未定義行為
+        U sign = U(1) << (sizeof(U) * 8 - 1);
+        return (u & sign) ? ~u : (u | sign);
+    }
+};
+
+// 核心：依 keys 排序，vals 跟著一起搬 (vals 為 nullptr 時只排 keys)
+// V 應該是小的 trivially copyable 型態(index、id)，大的 payload 請用 radix_argsort
+template <class K, class V>
+void radix_sort_impl(K* keys, V* vals, size_t n, unsigned threads) {
+    typedef RadixKey<K> RK;
+    constexpr int PASSES = sizeof(K);
+    if (n < 2) return;
+    threads = chunk_threads(n, threads);
+
+    vector<K> key_buf(n);
+    vector<V> val_buf(vals ? n : 0);
+    K* ksrc = keys; K* kdst = key_buf.data();
+    V* vsrc = vals; V* vdst = vals ? val_buf.data() : nullptr;
+
+    vector<size_t> hist(size_t(threads) * 256);
+    for (int pass = 0; pass < PASSES; pass++) {
+        int shift = pass * 8;
+        fill(hist.begin(), hist.end(), 0);
+
+        parallel_chunks(n, threads, [&](unsigned t, size_t b, size_t e) {
+            size_t* h = &hist[size_t(t) * 256];
+            for (size_t i = b; i < e; i++) h[(RK::encode(ksrc[i]) >> shift) & 0xFF]++;
+        });
+
+        // 全部元素都落在同一個桶子(例如小數值的高位 byte 都是 0)，這輪不用搬
+        bool skip = false;
+        for (int d = 0; d < 256 && !skip; d++) {
+            size_t total = 0;
+            for (unsigned t = 0; t < threads; t++) total += hist[size_t(t) * 256 + d];
+            if (total == n) skip = true;
+            else if (total) break;
+        }
+        if (skip) continue;
+
+        size_t sum = 0;  // 依 (桶子, thread) 順序做 prefix sum，histogram 原地改成起點
+        for (int d = 0; d < 256; d++)
+            for (unsigned t = 0; t < threads; t++) {
+                size_t c = hist[size_t(t) * 256 + d];
+                hist[size_t(t) * 256 + d] = sum;
+                sum += c;
+            }
+
+        parallel_chunks(n, threads, [&](unsigned t, size_t b, size_t e) {
+            size_t* off = &hist[size_t(t) * 256];
+            for (size_t i = b; i < e; i++) {
+                size_t pos = off[(RK::encode(ksrc[i]) >> shift) & 0xFF]++;
+                kdst[pos] = ksrc[i];
+                if (vsrc) vdst[pos] = vsrc[i];
+            }
+        });
+        swap(ksrc, kdst);
+        swap(vsrc, vdst);
+    }
+
+    // 搬了奇數輪時結果在暫存陣列，要複製回來
+    if (ksrc != keys) {
+        memcpy(keys, ksrc, n * sizeof(K));
+        if (vals) memcpy(vals, vsrc, n * sizeof(V));
+    }
+}
+
+// 排序 int / unsigned / int64 / float / double 等 vector
+template <class K>
+void radix_sort(vector<K>& keys, unsigned threads = 0) {
+    radix_sort_impl<K, char>(keys.data(), nullptr, keys.size(), threads);
+}
+
+// key/value 一起排序 (stable)，keys.size() 要等於 vals.size()
+template <class K, class V>
+void radix_sort(vector<K>& keys, vector<V>& vals, unsigned threads = 0) {
+    static_assert(is_trivially_copyable<V>::value, "value 要是 trivially copyable，大型 payload 請用 radix_argsort");
+    radix_sort_impl(keys.data(), vals.data(), keys.size(), threads);
+}
+
+// 回傳排序後的索引 perm，使 keys[perm[0]] <= keys[perm[1]] <= ...，keys 本身不動
+// payload (例如 string) 不用搬，之後用 perm 存取即可
+// 索引預設 uint32_t (搬的資料較少)，超過 4G 筆時用 radix_argsort<K, uint64_t>
+template <class K, class I = uint32_t>
+vector<I> radix_argsort(const vector<K>& keys, unsigned threads = 0) {
+    static_assert(is_integral<I>::value && is_unsigned<I>::value, "索引要是 unsigned 整數");
+    if (!keys.empty() && keys.size() - 1 > numeric_limits<I>::max())
+        throw length_error("radix_argsort: 索引型態放不下 keys.size()，請用較大的 I");
+    vector<K> k(keys);
+    vector<I> perm(keys.size());
+    iota(perm.begin(), perm.end(), I(0));
+    radix_sort_impl(k.data(), perm.data(), k.size(), threads);
+    return perm;
+}
+
+//###################################
+//############ Benchmark ############
+//###################################
+
+struct Record {   // 模擬 map<int,string> f 那種 (int key, payload) 資料
+    int key;
+    string value;
+};
+
+template <class F>
+double time_ms(F fn) {
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    // 用法：./radix [N] [threads]，N 預設 1M (可給到 500000000，記憶體約需 N*64 bytes)
+    size_t N = argc > 1 ? stoull(argv[1]) : 1000000;
+    unsigned T = argc > 2 ? stoul(argv[2]) : 0;
+
+    mt19937_64 rng(42);
+    vector<int> a(N);
+    for (auto& x : a) x = (int)rng();
+
+    vector<int> b = a, c = a, d = a;
+    printf("N = %zu, threads = %u\n", N, chunk_threads(N, T));
+    printf("int32  std::sort        %8.1f ms\n", time_ms([&]{ sort(b.begin(), b.end()); }));
+    printf("int32  std::stable_sort %8.1f ms\n", time_ms([&]{ stable_sort(c.begin(), c.end()); }));
+    printf("int32  radix_sort       %8.1f ms\n", time_ms([&]{ radix_sort(d, T); }));
+    cout << (d == b ? "結果相同" : "結果錯誤!") << endl;
+
+    vector<uint64_t> u(N);
+    for (auto& x : u) x = rng();
+    vector<uint64_t> u2 = u;
+    printf("uint64 std::sort        %8.1f ms\n", time_ms([&]{ sort(u.begin(), u.end()); }));
+    printf("uint64 radix_sort       %8.1f ms\n", time_ms([&]{ radix_sort(u2, T); }));
+    cout << (u == u2 ? "結果相同" : "結果錯誤!") << endl;
+
+    vector<float> fl(N);
+    uniform_real_distribution<float> dist(-1e6f, 1e6f);
+    for (auto& x : fl) x = dist(rng);
+    vector<float> fl2 = fl;
+    printf("float  std::sort        %8.1f ms\n", time_ms([&]{ sort(fl.begin(), fl.end()); }));
+    printf("float  radix_sort       %8.1f ms\n", time_ms([&]{ radix_sort(fl2, T); }));
+    cout << (fl == fl2 ? "結果相同" : "結果錯誤!") << endl;
+
+    // key + id：value 是 trivially copyable 的 id，N 筆全部都排
+    vector<pair<int, uint32_t>> kv(N);
+    for (size_t i = 0; i < N; i++) kv[i] = {a[i], uint32_t(i)};
+    vector<int> all_keys = a;
+    vector<uint32_t> all_ids(N);
+    iota(all_ids.begin(), all_ids.end(), 0u);
+    auto by_first = [](const pair<int, uint32_t>& x, const pair<int, uint32_t>& y){ return x.first < y.first; };
+    printf("key+id std::stable_sort %8.1f ms\n", time_ms([&]{ stable_sort(kv.begin(), kv.end(), by_first); }));
+    printf("key+id radix_sort       %8.1f ms\n", time_ms([&]{ radix_sort(all_keys, all_ids, T); }));
+    bool kv_ok = true;
+    for (size_t i = 0; i < N; i++) kv_ok &= kv[i].first == all_keys[i] && kv[i].second == all_ids[i];
+    cout << (kv_ok ? "結果相同" : "結果錯誤!") << endl;
+
+    // key/value：搬整個 Record (含 string) vs 只排 key + index
+    // 每筆 string 約 40 bytes 以上，這段只取前 2M 筆，避免 N 很大時記憶體不夠
+    size_t M = min<size_t>(N, 2000000);
+    vector<Record> recs(M);
+    for (size_t i = 0; i < M; i++) recs[i] = {a[i], "value_" + to_string(i)};
+    vector<Record> recs2 = recs;
+    vector<int> keys(M);
+    for (size_t i = 0; i < M; i++) keys[i] = recs[i].key;
+
+    auto by_key = [](const Record& x, const Record& y){ return x.key < y.key; };
+    double t_stable = time_ms([&]{ stable_sort(recs2.begin(), recs2.end(), by_key); });
+    printf("record std::stable_sort %8.1f ms (M = %zu)\n", t_stable, M);
+    vector<uint32_t> perm;
+    printf("record radix_argsort    %8.1f ms\n", time_ms([&]{ perm = radix_argsort(keys, T); }));
+    bool ok = true;
+    for (size_t i = 0; i < M; i++) ok &= recs[perm[i]].value == recs2[i].value;  // stable 所以順序要完全一樣
+    cout << (ok ? "結果相同" : "結果錯誤!") << endl;
+
+    vector<uint32_t> ids(M);
+    iota(ids.begin(), ids.end(), 0u);
+    radix_sort(keys, ids, T);   // key 和 value 一起排
+    cout << (ids == perm ? "結果相同" : "結果錯誤!") << endl;
+}
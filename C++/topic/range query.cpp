@@ -0,0 +1,371 @@
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <limits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include "parallel.h"   //parallel_chunks、chunk_threads (和 radix sort.cpp 共用)
+
+using namespace std;
+
+//###################################
+//########### Range Query ###########
+//###################################
+
+// 對陣列 a、b、c 問「第 l 到 r 個的和 / 最小值」，直接跑迴圈是 O(n)
+// 查詢很多次、陣列又常常被修改時，先建一個輔助結構：
+//
+//                      建立          查詢        修改
+//   Fenwick tree       O(n)          O(log n)    單點 O(log n)       只能做有反運算的 (例如加法)
+//   Lazy segment tree  O(n)          O(log n)    區間 O(log n)       區間加、區間和/最小/最大
+//   Sparse table       O(n log n)    O(1)        不能修改            min/max 這種重複算也沒關係的運算
+//                      (記憶體也是 n log n：n = 4M 的 long long 約 700MB)
+//
+// 記憶體配置：都是連續的陣列，沒有 pointer
+//   segment tree 用 Eytzinger (BFS) 順序：根在 1，節點 i 的小孩在 2i、2i+1
+//   上面幾層永遠擠在最前面幾條 cache line，每次查詢都會經過，很快就一直待在 cache 裡
+//   Fenwick tree 本身就是 1-based 的隱式陣列 (i 的父節點是 i + (i & -i))，同樣沒有 pointer
+//
+// 陣列很大時，建立可以分給多個 thread (參數 threads，0 表示使用所有核心)
+
+//###################################
+//########### Fenwick Tree ##########
+//###################################
+
+// t_[i] 存 a[i - lowbit(i), i) 的和 (1-based，lowbit(i) = i & -i)
+template <class T>
+class Fenwick {
+public:
+    explicit Fenwick(size_t n = 0) : t_(n + 1) {}
+
+    // 由現有陣列建立，O(n)
+    Fenwick(const T* a, size_t n, unsigned threads = 1) : t_(n + 1) {
+        threads = chunk_threads(n, threads);
+        if (threads == 1) {
+            // 每個節點把自己加到父節點，一次就完成 (不用做 n 次 add)
+            for (size_t i = 1; i <= n; i++) t_[i] += a[i - 1];
+            for (size_t i = 1; i <= n; i++) {
+                size_t j = i + (i & (~i + 1));
+                if (j <= n) t_[j] += t_[i];
+            }
+            return;
+        }
+        // 平行：先算前綴和 P，t_[i] = P[i] - P[i - lowbit(i)]，每個 i 互不相關
+        vector<T> p(n + 1);
+        vector<T> part(threads + 1);
+        parallel_chunks(n, threads, [&](unsigned t, size_t b, size_t e) {   // 1. 每段自己的和
+            T s = T();
+            for (size_t i = b; i < e; i++) s += a[i];
+            part[t + 1] = s;
+        });
+        for (unsigned t = 0; t < threads; t++) part[t + 1] += part[t];      // 2. 各段的起點
+        parallel_chunks(n, threads, [&](unsigned t, size_t b, size_t e) {   // 3. 每段從起點往下累加
+            T s = part[t];
+            for (size_t i = b; i < e; i++) p[i + 1] = s += a[i];
+        });
+        parallel_chunks(n, threads, [&](unsigned, size_t b, size_t e) {
+            for (size_t i = b + 1; i <= e; i++) t_[i] = p[i] - p[i - (i & (~i + 1))];
+        });
+    }
+
+    size_t size() const { return t_.size() - 1; }
+
+    void add(size_t i, T d) {
+        for (i++; i < t_.size(); i += i & (~i + 1)) t_[i] += d;
+    }
+
+    // a[0, i) 的和
+    T prefix(size_t i) const {
+        T s = T();
+        for (; i > 0; i -= i & (~i + 1)) s += t_[i];
+        return s;
+    }
+
+    T sum(size_t l, size_t r) const { return prefix(r) - prefix(l); }   // a[l, r)
+
+    // 第一個讓 prefix(i + 1) >= target 的 i，沒有就回傳 size()
+    // 從最高的 2 的次方往下走，O(log n)；所有元素都不是負數時才有意義
+    size_t lower_bound(T target) const {
+        size_t pos = 0, n = size();
+        size_t step = 1;
+        while (step * 2 <= n) step *= 2;
+        for (; step > 0; step /= 2)
+            if (pos + step <= n && t_[pos + step] < target) {
+                pos += step;
+                target -= t_[pos];
+            }
+        return pos;
+    }
+
+private:
+    vector<T> t_;
+};
+
+//###################################
+//######## Lazy Segment Tree ########
+//###################################
+
+// 區間加一個數、查區間和 / 最小值 / 最大值
+// 修改整段時只標記在完整覆蓋的節點上 (lazy)，等之後有人經過時才傳給小孩
+// 不用遞迴，從葉子往上走 (bottom-up)：先把 l、r 兩條路徑上的 lazy 往下推，再像一般 segment tree 一樣往上收
+template <class T>
+class LazySegTree {
+public:
+    LazySegTree(const T* a, size_t n, unsigned threads = 1) : n_(n) {
+        log_ = 0;
+        while ((size_t(1) << log_) < n) log_++;
+        size_ = size_t(1) << log_;
+        t_.assign(2 * size_, identity());   // 補到 2 的次方，多出來的葉子不影響 sum/min/max
+        threads = chunk_threads(size_, threads);
+        parallel_chunks(n, threads, [&](unsigned, size_t b, size_t e) {
+            for (size_t i = b; i < e; i++) t_[size_ + i] = Node{a[i], a[i], a[i], T()};
+        });
+        // 由下往上一層一層算，同一層的節點互不相關；上面幾層很小，直接算
+        for (size_t s = size_ / 2; s >= 1; s /= 2) {
+            parallel_chunks(s, chunk_threads(s, threads), [&](unsigned, size_t b, size_t e) {
+                for (size_t x = s + b; x < s + e; x++) pull(x);
+            });
+        }
+    }
+
+    size_t size() const { return n_; }
+
+    // a[l, r) 每個加 v
+    void add(size_t l, size_t r, T v) {
+        if (l >= r) return;
+        l += size_;
+        r += size_;
+        push_paths(l, r);
+        for (size_t x = l, y = r; x < y; x >>= 1, y >>= 1) {
+            if (x & 1) { apply(x, len_of(x), v); x++; }
+            if (y & 1) { y--; apply(y, len_of(y), v); }
+        }
+        for (int i = 1; i <= log_; i++) {   // 兩條路徑上的祖先重新計算
+            if (((l >> i) << i) != l) pull(l >> i);
+            if (((r >> i) << i) != r) pull((r - 1) >> i);
+        }
+    }
+
+    T sum(size_t l, size_t r) { return query(l, r).sum; }
+    T min(size_t l, size_t r) { return query(l, r).mn; }   // l >= r 時回傳 T 的最大值
+    T max(size_t l, size_t r) { return query(l, r).mx; }
+
+private:
+    struct Node { T sum, mn, mx, lazy; };   // lazy：已經加到自己身上、還沒傳給小孩的值
+    size_t n_, size_;
+    int log_;
+    vector<Node> t_;
+
+    static Node identity() { return Node{T(), numeric_limits<T>::max(), numeric_limits<T>::lowest(), T()}; }
+    static Node combine(const Node& a, const Node& b) {
+        return Node{a.sum + b.sum, std::min(a.mn, b.mn), std::max(a.mx, b.mx), T()};
+    }
+
+    // 節點 x 底下真正的元素個數 (補出來的葉子不算)：x 在第 d 層，涵蓋 size_ >> d 個葉子
+    size_t len_of(size_t x) const {
+        int d = 63 - __builtin_clzll((unsigned long long)x);
+        size_t w = size_ >> d;
+        size_t l = (x - (size_t(1) << d)) * w;
+        return l >= n_ ? 0 : std::min(w, n_ - l);
+    }
+
+    void apply(size_t x, size_t len, T v) {
+        if (len == 0) return;   // 整個都是補出來的，min/max 維持 identity
+        t_[x].sum += v * T(len);
+        t_[x].mn += v;
+        t_[x].mx += v;
+        t_[x].lazy += v;
+    }
+
+    void push(size_t x) {
+        if (t_[x].lazy == T()) return;
+        apply(2 * x, len_of(2 * x), t_[x].lazy);
+        apply(2 * x + 1, len_of(2 * x + 1), t_[x].lazy);
+        t_[x].lazy = T();
+    }
+
+    void pull(size_t x) {
+        T lz = t_[x].lazy;
+        t_[x] = combine(t_[2 * x], t_[2 * x + 1]);
+        t_[x].lazy = lz;
+    }
+
+    // 葉子 l 和 r - 1 的祖先由上往下推 lazy (只有沒被 [l, r) 完整覆蓋的才需要)
+    void push_paths(size_t l, size_t r) {
+        for (int i = log_; i >= 1; i--) {
+            if (((l >> i) << i) != l) push(l >> i);
+            if (((r >> i) << i) != r) push((r - 1) >> i);
+        }
+    }
+
+    Node query(size_t l, size_t r) {
+        if (l >= r) return identity();
+        l += size_;
+        r += size_;
+        push_paths(l, r);
+        Node left = identity(), right = identity();
+        for (; l < r; l >>= 1, r >>= 1) {
+            if (l & 1) left = combine(left, t_[l++]);
+            if (r & 1) right = combine(t_[--r], right);
+        }
+        return combine(left, right);
+    }
+};
+
+//###################################
+//########### Sparse Table ##########
+//###################################
+
+template <class T> struct MinOp { T operator()(const T& a, const T& b) const { return b < a ? b : a; } };
+template <class T> struct MaxOp { T operator()(const T& a, const T& b) const { return a < b ? b : a; } };
+
+// lv_[k][i] = op(a[i, i + 2^k))，查詢 [l, r) 時用兩段長度 2^k 的區間蓋住 (會重疊，所以 op 要滿足 op(x,x)=x)
+template <class T, class Op = MinOp<T>>
+class SparseTable {
+public:
+    SparseTable(const T* a, size_t n, unsigned threads = 1) {
+        if (n == 0) return;
+        threads = chunk_threads(n, threads);
+        lv_.emplace_back(a, a + n);
+        for (size_t k = 1; (size_t(1) << k) <= n; k++) {
+            size_t half = size_t(1) << (k - 1);
+            size_t len = n - (size_t(1) << k) + 1;
+            lv_.emplace_back(len);
+            const vector<T>& prev = lv_[k - 1];
+            vector<T>& cur = lv_[k];
+            parallel_chunks(len, threads, [&](unsigned, size_t b, size_t e) {   // 同一層每格互不相關
+                for (size_t i = b; i < e; i++) cur[i] = op_(prev[i], prev[i + half]);
+            });
+        }
+    }
+
+    T query(size_t l, size_t r) const {   // a[l, r)，需要 l < r
+        int k = 63 - __builtin_clzll((unsigned long long)(r - l));
+        return op_(lv_[k][l], lv_[k][r - (size_t(1) << k)]);
+    }
+
+private:
+    vector<vector<T>> lv_;
+    Op op_;
+};
+
+//###################################
+//############ Benchmark ############
+//###################################
+
+template <class F>
+double time_ms(F fn) {
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    // 用法：./range [n] [查詢次數] [threads]
+    size_t n = argc > 1 ? stoull(argv[1]) : (1 << 22);
+    size_t Q = argc > 2 ? stoull(argv[2]) : 1000000;
+    unsigned T = argc > 3 ? unsigned(atoi(argv[3])) : 0;
+
+    mt19937_64 rng(1);
+    vector<long long> a(n);
+    for (auto& x : a) x = (long long)(rng() % 1000);
+    vector<pair<size_t, size_t>> qs(Q);
+    for (auto& q : qs) {
+        size_t l = rng() % n, r = rng() % n;
+        if (l > r) swap(l, r);
+        q = {l, r + 1};
+    }
+    printf("n = %zu, Q = %zu\n", n, Q);
+
+    // 建立：單執行緒 vs 多執行緒
+    double tf1 = time_ms([&]{ Fenwick<long long> f(a.data(), n, 1); });
+    double tfp = time_ms([&]{ Fenwick<long long> f(a.data(), n, T); });
+    double ts1 = time_ms([&]{ LazySegTree<long long> s(a.data(), n, 1); });
+    double tsp = time_ms([&]{ LazySegTree<long long> s(a.data(), n, T); });
+    double tt1 = time_ms([&]{ SparseTable<long long> s(a.data(), n, 1); });
+    double ttp = time_ms([&]{ SparseTable<long long> s(a.data(), n, T); });
+    printf("建立 (1 thread / %u threads)\n", chunk_threads(n, T));
+    printf("  Fenwick        %8.1f / %8.1f ms\n", tf1, tfp);
+    printf("  LazySegTree    %8.1f / %8.1f ms\n", ts1, tsp);
+    printf("  SparseTable    %8.1f / %8.1f ms\n", tt1, ttp);
+
+    Fenwick<long long> fw(a.data(), n, T);
+    LazySegTree<long long> st(a.data(), n, T);
+    SparseTable<long long> sp(a.data(), n, T);
+
+    // 查詢：迴圈只跑一小部分，再換算成 Q 次
+    size_t Qn = min<size_t>(Q, 200);
+    long long chk_loop = 0, chk_f = 0, chk_s = 0, mn_loop = 0, mn_s = 0, mn_t = 0;
+    double t_loop = time_ms([&]{
+        for (size_t q = 0; q < Qn; q++) {
+            long long s = 0, m = a[qs[q].first];
+            for (size_t i = qs[q].first; i < qs[q].second; i++) { s += a[i]; m = min(m, a[i]); }
+            chk_loop += s;
+            mn_loop += m;
+        }
+    }) * double(Q) / double(Qn);
+    double t_f = time_ms([&]{ for (auto& q : qs) chk_f += fw.sum(q.first, q.second); });
+    double t_s = time_ms([&]{ for (auto& q : qs) chk_s += st.sum(q.first, q.second); });
+    double t_sm = time_ms([&]{ for (auto& q : qs) mn_s += st.min(q.first, q.second); });
+    double t_t = time_ms([&]{ for (auto& q : qs) mn_t += sp.query(q.first, q.second); });
+
+    long long chk_f_part = 0, chk_s_part = 0, mn_s_part = 0, mn_t_part = 0;   // 和迴圈比對前 Qn 筆
+    for (size_t q = 0; q < Qn; q++) {
+        chk_f_part += fw.sum(qs[q].first, qs[q].second);
+        chk_s_part += st.sum(qs[q].first, qs[q].second);
+        mn_s_part += st.min(qs[q].first, qs[q].second);
+        mn_t_part += sp.query(qs[q].first, qs[q].second);
+    }
+    bool ok = chk_f_part == chk_loop && chk_s_part == chk_loop && mn_s_part == mn_loop && mn_t_part == mn_loop
+              && chk_f == chk_s && mn_s == mn_t;
+    printf("%zu 次區間查詢\n", Q);
+    printf("  迴圈 sum+min   %8.1f ms (估計)\n", t_loop);
+    printf("  Fenwick sum    %8.1f ms\n", t_f);
+    printf("  SegTree sum    %8.1f ms\n", t_s);
+    printf("  SegTree min    %8.1f ms\n", t_sm);
+    printf("  SparseTable min%8.1f ms  %s\n", t_t, ok ? "結果相同" : "結果錯誤!");
+
+    // 修改和查詢交錯：一半單點加值 / 區間加值，一半查詢
+    vector<long long> b = a;
+    long long r_f = 0, r_s = 0;
+    double t_fu = time_ms([&]{
+        for (size_t q = 0; q < Q; q++) {
+            if (q & 1) r_f += fw.sum(qs[q].first, qs[q].second);
+            else fw.add(qs[q].first, (long long)(q % 7));
+        }
+    });
+    double t_su = time_ms([&]{
+        for (size_t q = 0; q < Q; q++) {
+            if (q & 1) r_s += st.sum(qs[q].first, qs[q].second);
+            else st.add(qs[q].first, qs[q].first + 1, (long long)(q % 7));
+        }
+    });
+    for (size_t q = 0; q < Q; q += 2) b[qs[q].first] += (long long)(q % 7);
+    double t_sr = time_ms([&]{   // 真正的區間加值
+        for (size_t q = 0; q < Q; q += 2) st.add(qs[q].first, qs[q].second, 1);
+    });
+    bool ok2 = r_f == r_s;
+    if (Q <= 100000) {   // 小的時候用迴圈重算全部檢查
+        for (size_t q = 0; q < Q; q += 2)
+            for (size_t i = qs[q].first; i < qs[q].second; i++) b[i] += 1;
+        for (size_t q = 0; q < Q && ok2; q++) {
+            long long s = 0, m = b[qs[q].first];
+            for (size_t i = qs[q].first; i < qs[q].second; i++) { s += b[i]; m = min(m, b[i]); }
+            ok2 = st.sum(qs[q].first, qs[q].second) == s && st.min(qs[q].first, qs[q].second) == m;
+        }
+    }
+    printf("修改 + 查詢交錯 %zu 次\n", Q);
+    printf("  Fenwick 單點   %8.1f ms\n", t_fu);
+    printf("  SegTree 單點   %8.1f ms  %s\n", t_su, ok2 ? "結果相同" : "結果錯誤!");
+    printf("  SegTree 區間加 %8.1f ms (%zu 次)\n", t_sr, (Q + 1) / 2);
+
+    // Fenwick lower_bound：前綴和第一次超過 target 的位置
+    long long total = fw.prefix(n);
+    long long target = total / 2;
+    size_t pos = fw.lower_bound(target);
+    printf("  lower_bound(%lld) = %zu  %s\n", target, pos,
+           (fw.prefix(pos + 1) >= target && (pos == 0 || fw.prefix(pos) < target)) ? "結果相同" : "結果錯誤!");
+}
@@ -0,0 +1,330 @@
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+
+using namespace std;
+
+//###################################
+//########### Small Vector ##########
+//###################################
+
+// vector<int> c = {5,4,3,2,1}; 就算只有 5 個元素，資料也是放在 heap 上(new 一塊記憶體)
+// 元素很少的 vector 數量一多，花在配置記憶體和跟著 pointer 跳到 heap 的時間就很可觀
+//
+// SmallVector<T, N> 在物件本身裡面預留 N 個元素的空間 (inline buffer)
+// 元素不超過 N 個時完全不碰 heap，超過才跟 vector 一樣向 allocator 要一塊新空間 (spill)
+//
+// 注意：
+//   inline 時 move 不能只偷 pointer，元素要一個一個 move 過去
+//   所以 move 之後原本的 iterator 會失效 (vector 的 move 則不會)
+//   sizeof(SmallVector<T,N>) 約為 N*sizeof(T) + 24 bytes，N 不要開太大
+
+template <class T, size_t N, class Alloc = allocator<T>>
+class SmallVector : private Alloc {   // 繼承 Alloc 讓沒有狀態的 allocator 不佔空間
+    typedef allocator_traits<Alloc> AT;
+public:
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    SmallVector() : ptr_(inline_ptr()), size_(0), cap_(N) {}
+    explicit SmallVector(const Alloc& a) : Alloc(a), ptr_(inline_ptr()), size_(0), cap_(N) {}
+    explicit SmallVector(size_t n) : SmallVector() { resize(n); }
+    SmallVector(size_t n, const T& v) : SmallVector() { assign(n, v); }
+    SmallVector(initializer_list<T> il) : SmallVector() { assign(il.begin(), il.end()); }
+    template <class It, class = typename iterator_traits<It>::iterator_category>
+    SmallVector(It first, It last) : SmallVector() { assign(first, last); }
+
+    SmallVector(const SmallVector& o)
+        : Alloc(AT::select_on_container_copy_construction(o.alloc())), ptr_(inline_ptr()), size_(0), cap_(N) {
+        assign(o.begin(), o.end());
+    }
+    SmallVector(SmallVector&& o) noexcept(is_nothrow_move_constructible<T>::value)
+        : Alloc(std::move(o.alloc())), ptr_(inline_ptr()), size_(0), cap_(N) {
+        steal(o);
+    }
+    ~SmallVector() { clear(); release(); }
+
+    SmallVector& operator=(const SmallVector& o) {
+        if (this != &o) assign(o.begin(), o.end());
+        return *this;
+    }
+    SmallVector& operator=(SmallVector&& o) noexcept(is_nothrow_move_constructible<T>::value) {
+        if (this == &o) return *this;
+        clear();
+        release();
+        if (AT::propagate_on_container_move_assignment::value) alloc() = std::move(o.alloc());
+        if (AT::propagate_on_container_move_assignment::value || alloc() == o.alloc()) {
+            steal(o);
+        } else {   // allocator 不同，heap 空間不能直接拿，只能逐個 move
+            for (auto& x : o) emplace_back(std::move(x));
+            o.clear();
+        }
+        return *this;
+    }
+    SmallVector& operator=(initializer_list<T> il) { assign(il.begin(), il.end()); return *this; }
+
+    void assign(size_t n, const T& v) {
+        clear();
+        reserve(n);
+        for (size_t i = 0; i < n; i++) push_back(v);
+    }
+    template <class It, class = typename iterator_traits<It>::iterator_category>
+    void assign(It first, It last) {
+        clear();
+        for (; first != last; ++first) emplace_back(*first);
+    }
+
+    Alloc get_allocator() const { return alloc(); }
+
+    // 迭代器、存取：和 vector 一樣
+    iterator begin() { return ptr_; }
+    iterator end() { return ptr_ + size_; }
+    const_iterator begin() const { return ptr_; }
+    const_iterator end() const { return ptr_ + size_; }
+    const_iterator cbegin() const { return ptr_; }
+    const_iterator cend() const { return ptr_ + size_; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    T& operator[](size_t i) { return ptr_[i]; }
+    const T& operator[](size_t i) const { return ptr_[i]; }
+    T& at(size_t i) { if (i >= size_) throw out_of_range("SmallVector::at"); return ptr_[i]; }
+    const T& at(size_t i) const { if (i >= size_) throw out_of_range("SmallVector::at"); return ptr_[i]; }
+    T& front() { return ptr_[0]; }
+    T& back() { return ptr_[size_ - 1]; }
+    const T& front() const { return ptr_[0]; }
+    const T& back() const { return ptr_[size_ - 1]; }
+    T* data() { return ptr_; }
+    const T* data() const { return ptr_; }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return cap_; }
+    bool empty() const { return size_ == 0; }
+    bool is_inline() const { return ptr_ == inline_ptr(); }   // 資料是否還在物件內部
+
+    void reserve(size_t n) { if (n > cap_) grow(n); }
+
+    void shrink_to_fit() {   // 放得回 inline buffer 就搬回去
+        if (is_inline() || size_ == cap_) return;
+        SmallVector tmp(get_allocator());
+        tmp.reserve(size_);
+        for (auto& x : *this) tmp.emplace_back(std::move(x));
+        *this = std::move(tmp);
+    }
+
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == cap_) {
+            // args 可能參照自己裡面的元素 (v.push_back(v[0]))，先建好新元素再搬舊的
+            size_t new_cap = next_cap(size_ + 1);
+            T* p = AT::allocate(alloc(), new_cap);
+            AT::construct(alloc(), p + size_, std::forward<Args>(args)...);
+            move_to(p);
+            release();
+            ptr_ = p; cap_ = new_cap;
+        } else {
+            AT::construct(alloc(), ptr_ + size_, std::forward<Args>(args)...);
+        }
+        return ptr_[size_++];
+    }
+    void push_back(const T& v) { emplace_back(v); }
+    void push_back(T&& v) { emplace_back(std::move(v)); }
+    void pop_back() { AT::destroy(alloc(), ptr_ + --size_); }
+
+    void resize(size_t n) {
+        reserve(n);
+        while (size_ > n) pop_back();
+        while (size_ < n) emplace_back();
+    }
+    void resize(size_t n, const T& v) {
+        reserve(n);
+        while (size_ > n) pop_back();
+        while (size_ < n) emplace_back(v);
+    }
+
+    template <class... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        size_t i = pos - begin();
+        emplace_back(std::forward<Args>(args)...);
+        rotate(begin() + i, end() - 1, end());   // 新元素放在最後再轉到 pos
+        return begin() + i;
+    }
+    iterator insert(const_iterator pos, const T& v) { return emplace(pos, v); }
+    iterator insert(const_iterator pos, T&& v) { return emplace(pos, std::move(v)); }
+    iterator insert(const_iterator pos, size_t n, const T& v) {
+        size_t i = pos - begin();
+        T copy(v);   // v 可能是自己的元素，reserve 之後會失效
+        reserve(size_ + n);
+        for (size_t k = 0; k < n; k++) emplace_back(copy);
+        rotate(begin() + i, end() - n, end());
+        return begin() + i;
+    }
+    template <class It, class = typename iterator_traits<It>::iterator_category>
+    iterator insert(const_iterator pos, It first, It last) {
+        size_t i = pos - begin(), old = size_;
+        for (; first != last; ++first) emplace_back(*first);
+        rotate(begin() + i, begin() + old, end());
+        return begin() + i;
+    }
+    iterator insert(const_iterator pos, initializer_list<T> il) { return insert(pos, il.begin(), il.end()); }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+    iterator erase(const_iterator first, const_iterator last) {
+        iterator f = begin() + (first - cbegin()), l = begin() + (last - cbegin());
+        iterator new_end = std::move(l, end(), f);
+        while (end() != new_end) pop_back();
+        return f;
+    }
+
+    void clear() { while (size_) pop_back(); }
+
+    void swap(SmallVector& o) {
+        SmallVector tmp(std::move(o));
+        o = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    friend bool operator==(const SmallVector& a, const SmallVector& b) {
+        return a.size() == b.size() && equal(a.begin(), a.end(), b.begin());
+    }
+    friend bool operator!=(const SmallVector& a, const SmallVector& b) { return !(a == b); }
+    friend bool operator<(const SmallVector& a, const SmallVector& b) {
+        return lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+private:
+    T* ptr_;
+    size_t size_;
+    size_t cap_;
+    alignas(T) unsigned char buf_[N ? N * sizeof(T) : 1];   // inline buffer，未建構的原始記憶體
+
+    Alloc& alloc() { return *this; }
+    const Alloc& alloc() const { return *this; }
+    T* inline_ptr() { return reinterpret_cast<T*>(buf_); }
+    const T* inline_ptr() const { return reinterpret_cast<const T*>(buf_); }
+
+    size_t next_cap(size_t need) const { return max(need, cap_ * 2); }
+
+    void grow(size_t n) {
+        T* p = AT::allocate(alloc(), n);
+        move_to(p);
+        release();
+        ptr_ = p; cap_ = n;
+    }
+
+    // 把現有元素 move 到 p，並解構舊元素 (size_ 不變)
+    void move_to(T* p) {
+        for (size_t i = 0; i < size_; i++) {
+            AT::construct(alloc(), p + i, std::move_if_noexcept(ptr_[i]));
+            AT::destroy(alloc(), ptr_ + i);
+        }
+    }
+
+    // 歸還 heap 空間，回到 inline buffer (元素要先解構或搬走)
+    void release() {
+        if (!is_inline()) AT::deallocate(alloc(), ptr_, cap_);
+        ptr_ = inline_ptr(); cap_ = N;
+    }
+
+    // 接收 o 的內容：o 在 heap 上就直接拿走 pointer，在 inline 就逐個 move
+    void steal(SmallVector& o) {
+        if (!o.is_inline()) {
+            ptr_ = o.ptr_; size_ = o.size_; cap_ = o.cap_;
+            o.ptr_ = o.inline_ptr(); o.size_ = 0; o.cap_ = N;
+        } else {
+            for (size_t i = 0; i < o.size_; i++) AT::construct(alloc(), ptr_ + i, std::move(o.ptr_[i]));
+            size_ = o.size_;
+            o.clear();
+        }
+    }
+};
+
+template <class T, size_t N, class A>
+void swap(SmallVector<T, N, A>& a, SmallVector<T, N, A>& b) { a.swap(b); }
+
+//###################################
+//############ Benchmark ############
+//###################################
+
+// 計算 heap 配置次數用的 allocator
+static size_t g_allocs = 0;
+template <class T>
+struct CountingAlloc {
+    typedef T value_type;
+    CountingAlloc() = default;
+    template <class U> CountingAlloc(const CountingAlloc<U>&) {}
+    T* allocate(size_t n) { g_allocs++; return static_cast<T*>(::operator new(n * sizeof(T))); }
+    void deallocate(T* p, size_t) { ::operator delete(p); }
+    template <class U> bool operator==(const CountingAlloc<U>&) const { return true; }
+    template <class U> bool operator!=(const CountingAlloc<U>&) const { return false; }
+};
+
+template <class F>
+double time_ms(F fn) {
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+// 模擬「數百萬個 entity，每個有一個很短的 list」：建立、加總、銷毀
+template <class Vec>
+double run(size_t entities, int len, long long& sum) {
+    return time_ms([&]{
+        vector<Vec> lists(entities);
+        for (auto& l : lists)
+            for (int i = 0; i < len; i++) l.push_back(i);
+        for (auto& l : lists)
+            for (int x : l) sum += x;
+    });
+}
+
+int main(int argc, char** argv) {
+    // 用法：./small [entity 數]
+    size_t E = argc > 1 ? stoull(argv[1]) : 1000000;
+
+    // 基本用法和 vector 相同
+    SmallVector<int, 8> c = {5, 4, 3, 2, 1};   // 5 個元素都在 inline buffer
+    sort(c.begin(), c.end());
+    reverse(c.begin(), c.end());
+    c.insert(c.begin() + 1, 42);
+    c.resize(10);                               // 超過 8 個，搬到 heap
+    auto it = find(c.begin(), c.end(), 4);
+    cout << (it != c.end() ? "有" : "沒有") << " inline=" << c.is_inline() << endl;   // 有 inline=0
+
+    SmallVector<string, 2> s;
+    s.push_back("caterpillar");
+    s.push_back(s[0]);                          // 參照自己的元素也安全
+    s.push_back("Justin");
+    SmallVector<string, 2> s2(std::move(s));    // heap 上的資料直接轉移，不複製字串
+    cout << s2.size() << " " << s.size() << " " << s2[1] << endl;   // 3 0 caterpillar
+
+    printf("E = %zu 個 list\n", E);
+    printf("%4s %12s %12s %12s %12s\n", "len", "vector ms", "allocs", "Small<16> ms", "allocs");
+    for (int len : {0, 1, 2, 4, 8, 16, 32, 64}) {
+        long long s1 = 0, s2sum = 0;
+        g_allocs = 0;
+        double tv = run<vector<int, CountingAlloc<int>>>(E, len, s1);
+        size_t av = g_allocs;
+        g_allocs = 0;
+        double ts = run<SmallVector<int, 16, CountingAlloc<int>>>(E, len, s2sum);
+        size_t as = g_allocs;
+        printf("%4d %12.1f %12zu %12.1f %12zu%s\n", len, tv, av, ts, as, s1 == s2sum ? "" : "  結果錯誤!");
+    }
+}
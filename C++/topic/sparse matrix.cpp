@@ -0,0 +1,299 @@
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <numeric>
+#include <cstdint>
+#include <stdexcept>
+#include "parallel.h"   //chunk_threads、parallel_ranges (見 parallel.h)
+
+using namespace std;
+
+//###################################
+//########## Sparse Matrix ##########
+//###################################
+
+// int maze[R][C] 和 vector<vector<int>> vec(R, vector<int>(C, 0)) 每一格都要存
+// 如果 99% 以上都是 0，只存「不是 0 的格子」會省很多：
+//
+// COO (Coordinate):  三個陣列 row[k], col[k], val[k]，第 k 個非零元素在 (row[k], col[k])
+//                    順序不限、可以有重複，適合一格一格加進來，之後再轉成 CSR
+//
+// CSR (Compressed Sparse Row):
+//   val[]     所有非零值，依 row 排好
+//   col[]     每個值的 column
+//   row_ptr[] row i 的值放在 val[row_ptr[i]] ~ val[row_ptr[i+1]-1]，長度 rows+1
+//
+//   maze = {{0, 2, 0},      val     = {2, 4, 6}
+//           {4, 0, 6}}  ->  col     = {1, 0, 2}
+//                           row_ptr = {0, 1, 3}
+//
+// 記憶體：dense 為 R*C*sizeof(T)，CSR 為 nnz*(sizeof(T)+4) + (R+1)*8
+// 矩陣乘向量 (SpMV) y = A*x 只要走過 nnz 個元素，每個 row 互不相干，可以分給多個 thread
+
+template <class T>
+struct COO {
+    size_t rows = 0, cols = 0;
+    vector<uint32_t> row, col;
+    vector<T> val;
+
+    COO() {}
+    COO(size_t r, size_t c) : rows(r), cols(c) {}
+
+    void add(size_t r, size_t c, T v) {
+        if (r >= rows || c >= cols) throw out_of_range("COO::add");
+        row.push_back(uint32_t(r)); col.push_back(uint32_t(c)); val.push_back(v);
+    }
+    size_t nnz() const { return val.size(); }
+};
+
+template <class T>
+class CSR {
+public:
+    CSR() : rows_(0), cols_(0), row_ptr_(1, 0) {}
+
+    // 從 COO 建立：依 row 做 counting sort，同一格出現多次就相加
+    explicit CSR(const COO<T>& m) : rows_(m.rows), cols_(m.cols), row_ptr_(m.rows + 1, 0) {
+        for (uint32_t r : m.row) row_ptr_[r + 1]++;
+        partial_sum(row_ptr_.begin(), row_ptr_.end(), row_ptr_.begin());
+        col_.resize(m.nnz());
+        val_.resize(m.nnz());
+        vector<size_t> next(row_ptr_.begin(), row_ptr_.end() - 1);
+        for (size_t k = 0; k < m.nnz(); k++) {
+            size_t at = next[m.row[k]]++;
+            col_[at] = m.col[k];
+            val_[at] = m.val[k];
+        }
+        sort_and_merge_rows();
+    }
+
+    // 從 vector<vector<T>> 建立 (例如 vector<vector<int>> vec)
+    static CSR from_dense(const vector<vector<T>>& d) {
+        CSR m;
+        m.rows_ = d.size();
+        m.cols_ = d.empty() ? 0 : d[0].size();
+        m.row_ptr_.assign(m.rows_ + 1, 0);
+        for (size_t i = 0; i < m.rows_; i++) {
+            if (d[i].size() != m.cols_) throw invalid_argument("每個 row 長度要相同");
+            for (size_t j = 0; j < m.cols_; j++)
+                if (d[i][j] != T()) { m.col_.push_back(uint32_t(j)); m.val_.push_back(d[i][j]); }
+            m.row_ptr_[i + 1] = m.val_.size();
+        }
+        return m;
+    }
+
+    // 從連續的二維陣列建立 (例如 int maze[R][C]，傳 &maze[0][0], R, C)
+    static CSR from_dense(const T* d, size_t rows, size_t cols) {
+        CSR m;
+        m.rows_ = rows; m.cols_ = cols;
+        m.row_ptr_.assign(rows + 1, 0);
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < cols; j++)
+                if (d[i * cols + j] != T()) { m.col_.push_back(uint32_t(j)); m.val_.push_back(d[i * cols + j]); }
+            m.row_ptr_[i + 1] = m.val_.size();
+        }
+        return m;
+    }
+
+    vector<vector<T>> to_dense() const {
+        vector<vector<T>> d(rows_, vector<T>(cols_, T()));
+        for (size_t i = 0; i < rows_; i++)
+            for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) d[i][col_[k]] = val_[k];
+        return d;
+    }
+
+    void to_dense(T* d) const {   // 寫進連續的 rows*cols 陣列
+        fill(d, d + rows_ * cols_, T());
+        for (size_t i = 0; i < rows_; i++)
+            for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) d[i * cols_ + col_[k]] = val_[k];
+    }
+
+    COO<T> to_coo() const {
+        COO<T> m(rows_, cols_);
+        for (size_t i = 0; i < rows_; i++)
+            for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) m.add(i, col_[k], val_[k]);
+        return m;
+    }
+
+    // 一個 row 的非零元素：for (auto e : m.row(i)) { e.col; e.val; }
+    struct Entry { uint32_t col; T val; };
+    class RowView {
+    public:
+        class iterator {
+        public:
+            iterator(const uint32_t* c, const T* v) : c_(c), v_(v) {}
+            Entry operator*() const { return Entry{*c_, *v_}; }
+            iterator& operator++() { ++c_; ++v_; return *this; }
+            bool operator!=(const iterator& o) const { return c_ != o.c_; }
+        private:
+            const uint32_t* c_;
+            const T* v_;
+        };
+        RowView(const uint32_t* c, const T* v, size_t n) : c_(c), v_(v), n_(n) {}
+        iterator begin() const { return iterator(c_, v_); }
+        iterator end() const { return iterator(c_ + n_, v_ + n_); }
+        size_t size() const { return n_; }
+    private:
+        const uint32_t* c_;
+        const T* v_;
+        size_t n_;
+    };
+    RowView row(size_t i) const {
+        return RowView(col_.data() + row_ptr_[i], val_.data() + row_ptr_[i], row_ptr_[i + 1] - row_ptr_[i]);
+    }
+
+    // (i, j) 的值：row 內的 column 是排序好的，用 binary search
+    T at(size_t i, size_t j) const {
+        auto b = col_.begin() + row_ptr_[i], e = col_.begin() + row_ptr_[i + 1];
+        auto it = lower_bound(b, e, uint32_t(j));
+        return (it != e && *it == j) ? val_[it - col_.begin()] : T();
+    }
+
+    // 轉置：依 column 做 counting sort，O(nnz + rows + cols)
+    CSR transpose() const {
+        CSR t;
+        t.rows_ = cols_; t.cols_ = rows_;
+        t.row_ptr_.assign(cols_ + 1, 0);
+        for (uint32_t c : col_) t.row_ptr_[c + 1]++;
+        partial_sum(t.row_ptr_.begin(), t.row_ptr_.end(), t.row_ptr_.begin());
+        t.col_.resize(nnz());
+        t.val_.resize(nnz());
+        vector<size_t> next(t.row_ptr_.begin(), t.row_ptr_.end() - 1);
+        for (size_t i = 0; i < rows_; i++)   // 依 row 順序放進去，每個新 row 內的 column 自然是排序好的
+            for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) {
+                size_t at = next[col_[k]]++;
+                t.col_[at] = uint32_t(i);
+                t.val_[at] = val_[k];
+            }
+        return t;
+    }
+
+    // y = A * x，row 依非零元素個數平均分給各個 thread (不是平均分 row 數，不然密的 row 會拖慢某個 thread)
+    template <class U>
+    vector<U> spmv(const vector<U>& x, unsigned threads = 0) const {
+        if (x.size() != cols_) throw invalid_argument("spmv: x 長度要等於 cols");
+        vector<U> y(rows_);
+        threads = chunk_threads(nnz(), threads, 100000);   // 每個 thread 至少 10 萬個非零元素
+
+        vector<size_t> bounds(threads + 1, 0);   // row 的切點
+        for (unsigned t = 1; t <= threads; t++) {
+            size_t target = nnz() * t / threads;   // 第 t 段結束時累計的非零個數
+            size_t r1 = t == threads ? rows_ : size_t(lower_bound(row_ptr_.begin(), row_ptr_.end(), target) - row_ptr_.begin());
+            bounds[t] = max(bounds[t - 1], min(r1, rows_));
+        }
+        parallel_ranges(bounds, [&](unsigned, size_t r0, size_t r1) {
+            for (size_t i = r0; i < r1; i++) {
+                U s = U();
+                for (size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; k++) s += U(val_[k]) * x[col_[k]];
+                y[i] = s;
+            }
+        });
+        return y;
+    }
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    size_t nnz() const { return val_.size(); }
+    size_t bytes() const { return val_.size() * sizeof(T) + col_.size() * sizeof(uint32_t) + row_ptr_.size() * sizeof(size_t); }
+
+private:
+    size_t rows_, cols_;
+    vector<size_t> row_ptr_;
+    vector<uint32_t> col_;
+    vector<T> val_;
+
+    // 每個 row 內依 column 排序，同一格相加，值為 0 的去掉
+    void sort_and_merge_rows() {
+        size_t out = 0;
+        vector<pair<uint32_t, T>> tmp;
+        size_t begin = 0;
+        for (size_t i = 0; i < rows_; i++) {
+            size_t end = row_ptr_[i + 1];
+            tmp.clear();
+            for (size_t k = begin; k < end; k++) tmp.push_back({col_[k], val_[k]});
+            sort(tmp.begin(), tmp.end(), [](const pair<uint32_t, T>& a, const pair<uint32_t, T>& b) { return a.first < b.first; });
+            for (size_t k = 0; k < tmp.size();) {
+                uint32_t c = tmp[k].first;
+                T s = T();
+                for (; k < tmp.size() && tmp[k].first == c; k++) s += tmp[k].second;
+                if (s != T()) { col_[out] = c; val_[out] = s; out++; }
+            }
+            begin = end;
+            row_ptr_[i + 1] = out;
+        }
+        col_.resize(out);
+        val_.resize(out);
+    }
+};
+
+//###################################
+//############ Benchmark ############
+//###################################
+
+template <class F>
+double time_ms(F fn) {
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    // 用法：./sparse [N] [密度] [threads]
+    size_t N = argc > 1 ? stoull(argv[1]) : 100000;
+    double density = argc > 2 ? stod(argv[2]) : 0.001;
+    unsigned T = argc > 3 ? stoul(argv[3]) : 0;
+
+    // 筆記裡的 maze 和 vec
+    constexpr int R = 2, C = 3;
+    int maze[R][C] = {{0, 2, 0}, {4, 0, 6}};
+    CSR<int> m = CSR<int>::from_dense(&maze[0][0], R, C);
+    vector<vector<int>> vec = m.transpose().to_dense();   // 3*2
+    for (auto e : m.row(1)) cout << "(1," << e.col << ")=" << e.val << " ";
+    cout << "\n轉置後 vec[2][1] = " << vec[2][1] << ", 轉回來相同: " << (CSR<int>::from_dense(vec).transpose().to_dense()[1][2] == maze[1][2]) << endl;
+
+    // N*N，每格有 density 的機率不是 0
+    mt19937_64 rng(42);
+    size_t nnz = size_t(double(N) * N * density);
+    COO<int> coo(N, N);
+    coo.row.reserve(nnz); coo.col.reserve(nnz); coo.val.reserve(nnz);
+    for (size_t k = 0; k < nnz; k++) coo.add(rng() % N, rng() % N, int(rng() % 9) + 1);
+    CSR<int> A;
+    double t_build = time_ms([&]{ A = CSR<int>(coo); });
+    vector<double> x(N);
+    for (auto& v : x) v = double(rng() % 100) / 10;
+
+    vector<double> y;
+    int reps = 10;
+    double t_spmv = time_ms([&]{ for (int r = 0; r < reps; r++) y = A.spmv(x, T); }) / reps;
+    CSR<int> At;
+    double t_tr = time_ms([&]{ At = A.transpose(); });
+
+    printf("N = %zu x %zu, 密度 %.4f, nnz = %zu\n", N, N, density, A.nnz());
+    printf("CSR   %10.1f MB  建立 %7.1f ms  轉置 %7.1f ms  SpMV %7.2f ms (%.2f GFLOP/s)\n",
+           A.bytes() / 1e6, t_build, t_tr, t_spmv, 2.0 * A.nnz() / (t_spmv * 1e6));
+
+    // dense 的 vector<vector<int>> 在 100k x 100k 要 40 GB，配置不起來
+    // 量一個放得下的大小，再依格數換算
+    size_t n = min<size_t>(N, 4000);
+    vector<vector<int>> dense = CSR<int>(
+        [&]{ COO<int> c(n, n); for (size_t k = 0; k < size_t(double(n) * n * density); k++) c.add(rng() % n, rng() % n, 1); return c; }()
+    ).to_dense();
+    vector<double> xs(n, 1.0), ys(n);
+    double t_dense = time_ms([&]{
+        for (int r = 0; r < reps; r++)
+            for (size_t i = 0; i < n; i++) {
+                double s = 0;
+                for (size_t j = 0; j < n; j++) s += dense[i][j] * xs[j];
+                ys[i] = s;
+            }
+    }) / reps;
+    double scale = double(N) * N / (double(n) * n);
+    printf("dense %10.1f MB  乘向量 %7.2f ms (由 %zu x %zu 的 %.2f ms 換算)\n",
+           double(N) * N * sizeof(int) / 1e6, t_dense * scale, n, n, t_dense);
+
+    // 驗證：小矩陣上 SpMV 和 dense 結果相同
+    CSR<int> small = CSR<int>::from_dense(dense);
+    vector<double> ys2 = small.spmv(xs, T);
+    cout << (ys == ys2 ? "結果相同" : "結果錯誤!") << endl;
+}
@@ -0,0 +1,320 @@
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>    // mallinfo2 (glibc)
+
+using namespace std;
+
+//###################################
+//########## String Interning #######
+//###################################
+
+// map<int, string> f 裡如果大量重複 "first_value" 這種字串，每個 entry 都存一份：
+//   string 本身 32 bytes，超過 15 個字元 (SSO) 還要再 new 一塊，比較相等要逐字比
+//
+// interning：相同內容的字串只存一份，其他地方都存一個 4 bytes 的編號 (Handle)
+//   相等 == 比整數、hash 就是整數本身，容器裡每格只要 4 bytes
+//   字串內容放在 arena (一大塊一大塊配置的記憶體) 裡，永遠不搬移，string_view 可以一直用
+//
+// 多個 thread 同時 intern：依 hash 分成 SHARDS 個 shard，每個 shard 自己一把 lock、一張表、一個 arena
+//   不同 shard 的 thread 互不影響，lock 只在 intern 時用，view() 查字串不需要 lock
+//
+// 注意：
+//   Handle 只在產生它的 pool 裡有意義；< 比的是編號 (加入順序)，不是字典順序
+//   字串加進去就不會刪除，適合「種類少、重複多」的資料 (例如欄位名稱、類別、標籤)
+
+class InternPool {
+    static const int SHARD_BITS = 4;
+    static const uint32_t SHARDS = 1u << SHARD_BITS;
+    static const int FIRST_BITS = 8;                        // 第 0 個 block 存 256 個 string_view，之後每個加倍
+    static const uint32_t MAX_LOCAL = 1u << (32 - SHARD_BITS);
+    static const int MAX_BLOCKS = 32 - SHARD_BITS - FIRST_BITS + 1;
+    static const size_t ARENA_CHUNK = 64 * 1024;
+
+public:
+    // 4 bytes 的字串編號：低 SHARD_BITS 位是 shard，其餘是 shard 裡的序號
+    class Handle {
+    public:
+        Handle() : id_(0) {}   // 預設是空字串 (pool 建立時第一個加入)
+        uint32_t id() const { return id_; }
+        friend bool operator==(Handle a, Handle b) { return a.id_ == b.id_; }
+        friend bool operator!=(Handle a, Handle b) { return a.id_ != b.id_; }
+        friend bool operator<(Handle a, Handle b) { return a.id_ < b.id_; }
+    private:
+        friend class InternPool;
+        explicit Handle(uint32_t id) : id_(id) {}
+        uint32_t id_;
+    };
+
+    InternPool() : shards_(new Shard[SHARDS]) {
+        Handle empty = intern(string_view());
+        (void)empty;   // 空字串一定拿到 0 號 (見 shard_of)
+    }
+    InternPool(const InternPool&) = delete;
+    InternPool& operator=(const InternPool&) = delete;
+
+    // 回傳 s 的 handle，第一次出現時複製一份到 arena；可以同時從多個 thread 呼叫
+    Handle intern(string_view s) {
+        size_t h = hash<string_view>()(s);
+        uint32_t si = shard_of(h, s);
+        Shard& sh = shards_[si];
+        uint32_t tag = uint32_t(h >> 32) | 1;   // 表裡存 hash 的高位，先比它才比字串；|1 讓 0 代表空格
+        lock_guard<mutex> lock(sh.mu);
+        size_t mask = sh.tags.size() - 1;
+        for (size_t i = h & mask;; i = (i + 1) & mask) {   // open addressing，linear probing
+            if (sh.tags[i] == 0) break;
+            if (sh.tags[i] == tag && sh.get(sh.local[i]) == s) return Handle(sh.local[i] << SHARD_BITS | si);
+        }
+        if (sh.count >= MAX_LOCAL) throw length_error("InternPool: too many strings");
+        uint32_t local = sh.count;
+        sh.set(local, sh.store(s));
+        sh.count++;
+        if (sh.count * 2 > sh.tags.size()) sh.grow();   // 負載超過一半就放大，probe 才會短
+        sh.insert(h, tag, local);
+        return Handle(local << SHARD_BITS | si);
+    }
+
+    // 只查不加，找不到回傳 false
+    bool lookup(string_view s, Handle& out) const {
+        size_t h = hash<string_view>()(s);
+        uint32_t si = shard_of(h, s);
+        Shard& sh = shards_[si];
+        uint32_t tag = uint32_t(h >> 32) | 1;
+        lock_guard<mutex> lock(sh.mu);
+        size_t mask = sh.tags.size() - 1;
+        for (size_t i = h & mask; sh.tags[i] != 0; i = (i + 1) & mask)
+            if (sh.tags[i] == tag && sh.get(sh.local[i]) == s) { out = Handle(sh.local[i] << SHARD_BITS | si); return true; }
+        return false;
+    }
+
+    // 不用 lock：block 建立後不搬移，而拿到 handle 的 thread 一定看得到 intern 時寫入的內容
+    string_view view(Handle h) const { return shards_[h.id_ & (SHARDS - 1)].get(h.id_ >> SHARD_BITS); }
+    const char* c_str(Handle h) const { return view(h).data(); }   // arena 裡每個字串後面都有 '\0'
+
+    size_t size() const {
+        size_t n = 0;
+        for (uint32_t i = 0; i < SHARDS; i++) { lock_guard<mutex> lock(shards_[i].mu); n += shards_[i].count; }
+        return n;
+    }
+
+    // pool 自己用掉的記憶體 (arena + 表 + block)
+    size_t memory() const {
+        size_t n = sizeof(*this) + SHARDS * sizeof(Shard);
+        for (uint32_t i = 0; i < SHARDS; i++) {
+            const Shard& sh = shards_[i];
+            lock_guard<mutex> lock(sh.mu);
+            n += sh.arena_bytes + sh.tags.capacity() * 8;
+            for (int b = 0; b < MAX_BLOCKS && sh.blocks[b].load(memory_order_relaxed); b++) n += (size_t(1) << (b + FIRST_BITS)) * sizeof(string_view);
+        }
+        return n;
+    }
+
+private:
+    struct Shard {
+        mutable mutex mu;
+        vector<uint32_t> tags = vector<uint32_t>(16);   // hash 高位，0 表示空格
+        vector<uint32_t> local = vector<uint32_t>(16);  // 對應的序號
+        uint32_t count = 0;
+
+        // 序號 -> string_view：block 大小 256、512、1024...，用到才配置，配置後位址不變
+        // (和 vector 一樣每次加倍，但不搬移舊的，所以 view() 讀的時候不用 lock)
+        atomic<string_view*> blocks[MAX_BLOCKS] = {};
+
+        vector<unique_ptr<char[]>> arena;
+        size_t arena_left = 0;
+        char* arena_ptr = nullptr;
+        size_t arena_bytes = 0;
+
+        ~Shard() { for (auto& b : blocks) delete[] b.load(memory_order_relaxed); }
+
+        // 序號 + 256 的最高位決定在哪個 block，其餘的位元是 block 裡的位置
+        static void locate(uint32_t local_id, int& b, uint32_t& off) {
+            uint32_t v = local_id + (1u << FIRST_BITS);
+            int top = 31 - __builtin_clz(v);
+            b = top - FIRST_BITS;
+            off = v - (1u << top);
+        }
+        string_view get(uint32_t local_id) const {
+            int b; uint32_t off;
+            locate(local_id, b, off);
+            return blocks[b].load(memory_order_acquire)[off];
+        }
+        void set(uint32_t local_id, string_view s) {
+            int b; uint32_t off;
+            locate(local_id, b, off);
+            if (!blocks[b].load(memory_order_relaxed)) blocks[b].store(new string_view[size_t(1) << (b + FIRST_BITS)], memory_order_release);
+            blocks[b].load(memory_order_relaxed)[off] = s;
+        }
+
+        // 複製到 arena，長字串 (超過 chunk 的 1/4) 自己配一塊，避免浪費 chunk 剩下的空間
+        string_view store(string_view s) {
+            size_t need = s.size() + 1;
+            char* p;
+            if (need > ARENA_CHUNK / 4) {
+                arena.emplace_back(new char[need]);
+                p = arena.back().get();
+                arena_bytes += need;
+            } else {
+                if (need > arena_left) {
+                    arena.emplace_back(new char[ARENA_CHUNK]);
+                    arena_ptr = arena.back().get();
+                    arena_left = ARENA_CHUNK;
+                    arena_bytes += ARENA_CHUNK;
+                }
+                p = arena_ptr;
+                arena_ptr += need;
+                arena_left -= need;
+            }
+            if (!s.empty()) memcpy(p, s.data(), s.size());
+            p[s.size()] = '\0';
+            return string_view(p, s.size());
+        }
+
+        void insert(size_t h, uint32_t tag, uint32_t local_id) {
+            size_t mask = tags.size() - 1;
+            size_t i = h & mask;
+            while (tags[i] != 0) i = (i + 1) & mask;
+            tags[i] = tag;
+            local[i] = local_id;
+        }
+
+        // 兩倍大重新插入 (要重新算 hash，字串都在 arena 裡)
+        void grow() {
+            vector<uint32_t> old_local;
+            vector<uint32_t> old_tags;
+            old_tags.swap(tags);
+            old_local.swap(local);
+            tags.assign(old_tags.size() * 2, 0);
+            local.assign(old_tags.size() * 2, 0);
+            for (size_t i = 0; i < old_tags.size(); i++)
+                if (old_tags[i]) insert(hash<string_view>()(get(old_local[i])), old_tags[i], old_local[i]);
+        }
+    };
+
+    unique_ptr<Shard[]> shards_;
+
+    // 表裡的位置用 hash 低位、tag 用高 32 位，shard 取中間的位元，三者互不相關
+    // 空字串固定放 shard 0，才能讓 Handle() 預設值代表空字串
+    static uint32_t shard_of(size_t h, string_view s) {
+        return s.empty() ? 0 : uint32_t(h >> 24) & (SHARDS - 1);
+    }
+};
+
+namespace std {
+template <>
+struct hash<InternPool::Handle> {
+    size_t operator()(InternPool::Handle h) const { return h.id(); }   // 編號本身就是好的 hash，O(1)
+};
+}
+
+//###################################
+//############ Benchmark ############
+//###################################
+
+// 目前 heap 用了多少 bytes (glibc 的 mallinfo2，包含 malloc 每塊的額外開銷)
+size_t heap_used() {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+template <class F>
+double time_ms(F fn) {
+    auto t0 = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    // 用法：./intern [N 筆資料] [K 種字串] [threads]
+    size_t N = argc > 1 ? stoull(argv[1]) : 2000000;
+    size_t K = argc > 2 ? stoull(argv[2]) : 3000;
+    int T = argc > 3 ? atoi(argv[3]) : 4;
+
+    mt19937_64 rng(42);
+    vector<string> distinct;
+    for (size_t k = 0; k < K; k++)   // 20~40 個字元，超過 SSO，每個 string 都要另外 new
+        distinct.push_back("value_" + to_string(k) + "_" + string(14 + rng() % 20, char('a' + k % 26)));
+    vector<uint32_t> pick(N);
+    for (auto& p : pick) p = uint32_t(rng() % K);
+    printf("N = %zu, K = %zu 種字串\n", N, K);
+
+    // 1. vector<string> vs vector<Handle>
+    InternPool pool;
+    size_t h0 = heap_used();
+    vector<string> vs;
+    double t_vs = time_ms([&]{ vs.reserve(N); for (auto p : pick) vs.push_back(distinct[p]); });
+    size_t m_vs = heap_used() - h0;
+
+    h0 = heap_used();
+    vector<InternPool::Handle> vh;
+    double t_vh = time_ms([&]{ vh.reserve(N); for (auto p : pick) vh.push_back(pool.intern(distinct[p])); });
+    size_t m_vh = heap_used() - h0;   // 包含 pool 本身
+    bool same = true;
+    for (size_t i = 0; i < N; i++) same &= pool.view(vh[i]) == vs[i];
+    printf("vector<string>           %8.1f ms  %8.1f MB\n", t_vs, m_vs / 1e6);
+    printf("vector<Handle> + pool    %8.1f ms  %8.1f MB  (pool %zu 個字串，%.1f MB)  %s\n", t_vh, m_vh / 1e6,
+           pool.size(), pool.memory() / 1e6, same ? "結果相同" : "結果錯誤!");
+
+    // 2. map<int, string> vs map<int, Handle>：node 本身的開銷還在，但 value 從 32 bytes + heap 變成 4 bytes
+    h0 = heap_used();
+    {
+        map<int, string> f;
+        for (size_t i = 0; i < N; i++) f[int(i)] = distinct[pick[i]];
+        size_t m_f = heap_used() - h0;
+        map<int, InternPool::Handle> fh;
+        for (size_t i = 0; i < N; i++) fh[int(i)] = vh[i];
+        size_t m_fh = heap_used() - h0 - m_f;
+        printf("map<int,string>                     %8.1f MB\n", m_f / 1e6);
+        printf("map<int,Handle>                     %8.1f MB\n", m_fh / 1e6);
+    }
+
+    // 3. 相等比較：逐字比 vs 比整數
+    size_t eq_s = 0, eq_h = 0;
+    double t_eq_s = time_ms([&]{ for (size_t i = 1; i < N; i++) eq_s += vs[i] == vs[i - 1]; });
+    double t_eq_h = time_ms([&]{ for (size_t i = 1; i < N; i++) eq_h += vh[i] == vh[i - 1]; });
+    printf("string ==                %8.1f ms\n", t_eq_s);
+    printf("Handle ==                %8.1f ms  %s\n", t_eq_h, eq_s == eq_h ? "結果相同" : "結果錯誤!");
+
+    // 4. 當 hash key：計算每種字串出現幾次
+    unordered_map<string, int> cnt_s;
+    unordered_map<InternPool::Handle, int> cnt_h;
+    double t_hs = time_ms([&]{ for (auto& s : vs) cnt_s[s]++; });
+    double t_hh = time_ms([&]{ for (auto h : vh) cnt_h[h]++; });
+    bool cnt_ok = cnt_s.size() == cnt_h.size();
+    for (auto& kv : cnt_h) cnt_ok &= cnt_s[string(pool.view(kv.first))] == kv.second;
+    printf("unordered_map<string>    %8.1f ms\n", t_hs);
+    printf("unordered_map<Handle>    %8.1f ms  %s\n", t_hh, cnt_ok ? "結果相同" : "結果錯誤!");
+
+    // 5. 多個 thread 同時 intern 同一批字串，同樣的字串要拿到同樣的 handle
+    InternPool shared;
+    vector<vector<InternPool::Handle>> out(T, vector<InternPool::Handle>(N));
+    double t_mt = time_ms([&]{
+        vector<thread> pool_t;
+        for (int t = 0; t < T; t++)
+            pool_t.emplace_back([&, t]{
+                for (size_t i = 0; i < N; i++) {
+                    size_t j = (i + size_t(t) * N / T) % N;   // 每個 thread 從不同位置開始，才會互相搶
+                    out[t][j] = shared.intern(distinct[pick[j]]);
+                }
+            });
+        for (auto& th : pool_t) th.join();
+    });
+    bool mt_ok = shared.size() == pool.size();
+    for (int t = 1; t < T; t++) mt_ok &= out[t] == out[0];
+    for (size_t i = 0; i < N; i++) mt_ok &= shared.view(out[0][i]) == vs[i];
+    printf("%d threads intern         %8.1f ms  %s\n", T, t_mt, mt_ok ? "結果相同" : "結果錯誤!");
+}
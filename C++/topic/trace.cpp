@@ -0,0 +1,57 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include "trace.h"   // "" 表示和這個 .cpp 檔同一個資料夾
+
+using namespace std;
+
+// 示範 trace.h 的用法和量測每個 span 的成本
+//   g++ -O2 -DTRACE -pthread trace.cpp && ./a.out    輸出 trace.json
+//   g++ -O2 -pthread trace.cpp && ./a.out            關閉時，同樣的迴圈當作對照組
+
+void work(int id) {
+    TRACE_SCOPE("work");
+    long long s = 0;
+    for (int i = 0; i < 100; i++) {
+        TRACE_SCOPE("step");
+        for (int j = 0; j < 10000; j++) s += i ^ j;
+        TRACE_COUNTER("partial sum", s % 1000);
+    }
+    if (s == 42) cout << id << endl;   // 避免整個迴圈被最佳化掉
+}
+
+int main() {
+    const int N = 10000000;
+    volatile int sink = 0;
+
+#ifdef TRACE
+    // 先量一次時間戳記本身要多久：一個 span 至少要兩次
+    volatile uint64_t tsink = 0;
+    auto c0 = chrono::steady_clock::now();
+    for (int i = 0; i < N; i++) tsink = tsink + trace::now_ticks();
+    double tick_ns = chrono::duration<double, nano>(chrono::steady_clock::now() - c0).count() / N;
+    cout << "一次 now_ticks() 約 " << tick_ns << " ns" << endl;
+#endif
+
+    auto t0 = chrono::steady_clock::now();
+    for (int i = 0; i < N; i++) {
+        TRACE_SCOPE("empty");   // 空的 span，量到的就是 span 本身的成本
+        sink = sink + 1;
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / N;
+#ifdef TRACE
+    cout << "TRACE 開啟：每個 span 約 " << ns << " ns (目標 < 20 ns，" << (ns < 20 ? "達成" : "未達成") << ")" << endl;
+#else
+    cout << "TRACE 關閉：每次迴圈約 " << ns << " ns" << endl;
+#endif
+
+    {
+        TRACE_SCOPE("threads");
+        vector<thread> pool;
+        for (int t = 0; t < 4; t++) pool.emplace_back(work, t);
+        for (auto& th : pool) th.join();
+    }
+
+    TRACE_DUMP("trace.json");
+}
@@ -0,0 +1,193 @@
+#ifndef TRACE_H   //避免重複引入
+#define TRACE_H
+
+//###################################
+//############## Trace ##############
+//###################################
+
+// 用法：
+//   TRACE_SCOPE("sort");            從這行到所在的 {} 結束算一段 span (RAII：解構時記錄)
+//   TRACE_COUNTER("size", n);       記錄一個數值 (Perfetto 會畫成折線)
+//   TRACE_DUMP("trace.json");       輸出 Chrome trace 格式，用 chrome://tracing 或 ui.perfetto.dev 打開
+//
+// 編譯時加 -DTRACE 才會啟用；沒有定義時三個巨集都展開成空白，程式裡完全沒有這些程式碼
+//   g++ -O2 -DTRACE -pthread basic.cpp
+//
+// 記錄方式：
+//   每個 thread 有自己的 ring buffer (thread_local)，寫入只有自己一個 thread，不需要 lock
+//   滿了就從頭覆蓋，只保留最新的 CAPACITY 筆
+//   時間用 CPU 的 time stamp counter (rdtsc，一次約幾 ns)，輸出時才換算成微秒
+//   一個 span 只寫一筆 (開始時間 + 長度)，約 2 次 rdtsc + 一次寫入
+//
+// 成本 (trace.cpp 會量給你看)：目標是每個 span < 20 ns，在目前開發用的 VM 上「沒有達到」
+//   實測每個 span 約 25 ns (不同時間跑過 25~42 ns)，其中單獨一次 rdtsc 就約 12 ns，兩次就超過 20 ns
+//   扣掉兩次 rdtsc，寫 ring buffer 只多幾 ns，所以瓶頸是時間戳記本身，不是這裡的資料結構
+//   span 一定要有開始和結束兩個時間點，換成 clock_gettime(CLOCK_MONOTONIC_COARSE) 雖然一次只要約 4 ns，
+//   但解析度是 4 ms，量不出短的 span，所以沒有改用
+//   實體機的 rdtsc 通常比 VM 便宜，但沒有量過，要用請自己跑 trace.cpp 確認
+//
+// name 只存 pointer，必須是字串常數 (例如 "sort")，不能是會消失的 string
+
+#ifdef TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>   // __rdtsc()
+#endif
+
+namespace trace {
+
+inline uint64_t now_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();   // 沒有 rdtsc 的平台，單位為 ns
+#endif
+}
+
+// 量 10ms 內 tick 走了多少，得到每 ns 幾個 tick (只在輸出時算一次)
+inline double ticks_per_ns() {
+#if defined(__x86_64__) || defined(__i386__)
+    static double r = [] {
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = now_ticks();
+        while (std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(10)) {}
+        uint64_t c1 = now_ticks();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        return (c1 - c0) / ns;
+    }();
+    return r;
+#else
+    return 1.0;
+#endif
+}
+
+enum Kind : uint32_t { SPAN, COUNTER };
+
+struct Event {
+    const char* name;
+    uint64_t start;    // tick
+    uint64_t value;    // SPAN: 長度 (tick)，COUNTER: 數值
+    Kind kind;
+};
+
+struct Ring {
+    static const size_t CAPACITY = 1 << 16;   // 2 的次方，取餘數可以用 &
+    Event events[CAPACITY];
+    std::atomic<uint64_t> head{0};            // 總共寫過幾筆
+    uint32_t tid = 0;
+
+    void push(const Event& e) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        events[h & (CAPACITY - 1)] = e;
+        head.store(h + 1, std::memory_order_release);   // 先寫資料再更新 head，讀的 thread 看到 head 就看得到資料
+    }
+};
+
+// 所有 thread 的 ring：只有每個 thread 第一次記錄時要 lock 登記
+struct Registry {
+    std::mutex mu;
+    std::vector<Ring*> rings;
+    uint64_t origin = now_ticks();   // 時間零點
+};
+inline Registry& registry() { static Registry r; return r; }
+
+inline Ring& local_ring() {
+    // ring 不隨 thread 結束釋放，thread 結束後還能輸出它的紀錄
+    thread_local Ring* ring = [] {
+        Ring* r = new Ring;
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mu);
+        r->tid = uint32_t(reg.rings.size() + 1);
+        reg.rings.push_back(r);
+        return r;
+    }();
+    return *ring;
+}
+
+class Scope {
+public:
+    explicit Scope(const char* name) : name_(name), ring_(local_ring()), start_(now_ticks()) {}
+    ~Scope() { ring_.push(Event{name_, start_, now_ticks() - start_, SPAN}); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+private:
+    const char* name_;
+    Ring& ring_;
+    uint64_t start_;
+};
+
+inline void counter(const char* name, int64_t v) {
+    local_ring().push(Event{name, now_ticks(), uint64_t(v), COUNTER});
+}
+
+// name 可能含有 " 或 \ (例如 TRACE_SCOPE("parse \"key\""))，直接用 %s 印會讓 JSON 壞掉
+// JSON 字串裡 "、\ 和控制字元 (< 0x20) 都要跳脫
+inline void write_json_string(FILE* f, const char* s) {
+    std::fputc('"', f);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') { std::fputc('\\', f); std::fputc(c, f); }
+        else if (c < 0x20) std::fprintf(f, "\\u%04x", c);
+        else std::fputc(c, f);
+    }
+    std::fputc('"', f);
+}
+
+// 輸出 Chrome trace / Perfetto 都看得懂的 JSON
+// 應該在其他 thread 都停下來之後呼叫，否則正在被覆蓋的那幾筆可能不完整
+inline bool dump(const char* path) {
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+    Registry& reg = registry();
+    double tpn = ticks_per_ns();
+    std::lock_guard<std::mutex> lock(reg.mu);
+    std::fprintf(f, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (Ring* r : reg.rings) {
+        uint64_t head = r->head.load(std::memory_order_acquire);
+        uint64_t begin = head > Ring::CAPACITY ? head - Ring::CAPACITY : 0;
+        for (uint64_t i = begin; i < head; i++) {
+            const Event& e = r->events[i & (Ring::CAPACITY - 1)];
+            double ts = (int64_t(e.start - reg.origin)) / tpn / 1000.0;   // 微秒
+            std::fprintf(f, first ? "" : ",\n");
+            first = false;
+            std::fprintf(f, "{\"name\":");
+            write_json_string(f, e.name);
+            if (e.kind == SPAN)
+                std::fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                             r->tid, ts, e.value / tpn / 1000.0);
+            else
+                std::fprintf(f, ",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+                             r->tid, ts, (long long)e.value);
+        }
+    }
+    std::fprintf(f, "\n]}\n");
+    std::fclose(f);
+    return true;
+}
+
+}  // namespace trace
+
+// __LINE__ 要多包一層巨集才會先展開成數字，才能組出 trace_scope_12 這種不重複的變數名
+#define TRACE_CAT2(a, b) a##b
+#define TRACE_CAT(a, b) TRACE_CAT2(a, b)
+#define TRACE_SCOPE(name) trace::Scope TRACE_CAT(trace_scope_, __LINE__)(name)
+#define TRACE_COUNTER(name, v) trace::counter(name, int64_t(v))
+#define TRACE_DUMP(path) trace::dump(path)
+
+#else   // 沒有 -DTRACE：全部展開成空白
+
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_COUNTER(name, v) do {} while (0)
+#define TRACE_DUMP(path) do {} while (0)
+
+#endif  // TRACE
+
+#endif  // TRACE_H